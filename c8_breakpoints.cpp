@@ -0,0 +1,334 @@
+#include "c8_breakpoints.hpp"
+
+#include <cctype>
+#include <cstdlib>
+
+namespace yac8 {
+    /**
+     * A recursive descent parser that emits c8_condition bytecode, lowest precedence first.
+     */
+    class c8_condition_parser {
+        const std::string &text;
+        size_t position = 0;
+        c8_condition &condition;
+        int depth = 0;
+    public:
+        std::string error;
+
+        c8_condition_parser(const std::string &text, c8_condition &condition) : text(text), condition(condition) {}
+
+        bool parse() {
+            condition.code.clear();
+            condition.maxDepth = 0;
+            if(!logicalOr())
+                return false;
+            skipSpace();
+            if(position != text.size())
+                return fail("unexpected '" + text.substr(position, 1) + "'");
+            return true;
+        }
+
+    private:
+        bool fail(const std::string &message) {
+            if(error.empty())
+                error = message + " at column " + std::to_string(position + 1);
+            return false;
+        }
+
+        void skipSpace() {
+            while(position < text.size() && std::isspace((unsigned char) text[position]))
+                position++;
+        }
+
+        // consumes `token` if it's next
+        bool accept(const char *token) {
+            skipSpace();
+            size_t n = std::char_traits<char>::length(token);
+            if(text.compare(position, n, token) != 0)
+                return false;
+            // don't mistake '<=' for '<', '&&' for '&', etc.
+            if(n == 1 && position + 1 < text.size()) {
+                char next = text[position + 1];
+                if((token[0] == '<' || token[0] == '>' || token[0] == '!') && next == '=')
+                    return false;
+                if((token[0] == '&' || token[0] == '|') && next == token[0])
+                    return false;
+            }
+            position += n;
+            return true;
+        }
+
+        void emit(c8_condition::opcode op, int32_t arg = 0) {
+            condition.code.push_back({op, arg});
+            if(op <= c8_condition::PUSH_K) {
+                depth++;
+                condition.maxDepth = std::max(condition.maxDepth, depth);
+            } else if(op != c8_condition::NOT && op != c8_condition::NEG) {
+                depth--;
+            }
+        }
+
+        typedef bool (c8_condition_parser::*rule)();
+
+        // parses `next (token next)*` for a list of left-associative binary operators
+        bool binary(rule next, const char *const *tokens, const c8_condition::opcode *ops, int count) {
+            if(!(this->*next)())
+                return false;
+            while(true) {
+                int matched = -1;
+                for(int i = 0; i < count && matched < 0; i++) {
+                    if(accept(tokens[i]))
+                        matched = i;
+                }
+                if(matched < 0)
+                    return true;
+                if(!(this->*next)())
+                    return false;
+                emit(ops[matched]);
+            }
+        }
+
+        bool logicalOr() {
+            static const char *const tokens[] = {"||"};
+            static const c8_condition::opcode ops[] = {c8_condition::LOR};
+            return binary(&c8_condition_parser::logicalAnd, tokens, ops, 1);
+        }
+        bool logicalAnd() {
+            static const char *const tokens[] = {"&&"};
+            static const c8_condition::opcode ops[] = {c8_condition::LAND};
+            return binary(&c8_condition_parser::bitOr, tokens, ops, 1);
+        }
+        bool bitOr() {
+            static const char *const tokens[] = {"|"};
+            static const c8_condition::opcode ops[] = {c8_condition::OR};
+            return binary(&c8_condition_parser::bitXor, tokens, ops, 1);
+        }
+        bool bitXor() {
+            static const char *const tokens[] = {"^"};
+            static const c8_condition::opcode ops[] = {c8_condition::XOR};
+            return binary(&c8_condition_parser::bitAnd, tokens, ops, 1);
+        }
+        bool bitAnd() {
+            static const char *const tokens[] = {"&"};
+            static const c8_condition::opcode ops[] = {c8_condition::AND};
+            return binary(&c8_condition_parser::equality, tokens, ops, 1);
+        }
+        bool equality() {
+            static const char *const tokens[] = {"==", "!="};
+            static const c8_condition::opcode ops[] = {c8_condition::EQ, c8_condition::NE};
+            return binary(&c8_condition_parser::comparison, tokens, ops, 2);
+        }
+        bool comparison() {
+            static const char *const tokens[] = {"<=", ">=", "<", ">"};
+            static const c8_condition::opcode ops[] = {c8_condition::LE, c8_condition::GE, c8_condition::LT, c8_condition::GT};
+            return binary(&c8_condition_parser::additive, tokens, ops, 4);
+        }
+        bool additive() {
+            static const char *const tokens[] = {"+", "-"};
+            static const c8_condition::opcode ops[] = {c8_condition::ADD, c8_condition::SUB};
+            return binary(&c8_condition_parser::unary, tokens, ops, 2);
+        }
+
+        bool unary() {
+            if(accept("!")) {
+                if(!unary()) return false;
+                emit(c8_condition::NOT);
+                return true;
+            }
+            if(accept("-")) {
+                if(!unary()) return false;
+                emit(c8_condition::NEG);
+                return true;
+            }
+            return primary();
+        }
+
+        bool primary() {
+            skipSpace();
+            if(accept("(")) {
+                if(!logicalOr())
+                    return false;
+                if(!accept(")"))
+                    return fail("expected ')'");
+                return true;
+            }
+            if(position >= text.size())
+                return fail("unexpected end of expression");
+
+            if(std::isdigit((unsigned char) text[position])) {
+                const char *start = text.c_str() + position;
+                char *end;
+                // a leading zero doesn't make a literal octal, only 0x makes it anything but decimal
+                bool hex = start[0] == '0' && (start[1] == 'x' || start[1] == 'X');
+                long value = std::strtol(start, &end, hex ? 16 : 10);
+                position += end - start;
+                emit(c8_condition::PUSH_CONST, static_cast<int32_t>(value));
+                return true;
+            }
+
+            size_t start = position;
+            while(position < text.size() && std::isalnum((unsigned char) text[position]))
+                position++;
+            std::string name = text.substr(start, position - start);
+            for(char &c : name) {
+                c = static_cast<char>(std::toupper((unsigned char) c));
+            }
+
+            if(name.size() == 2 && name[0] == 'V' && std::isxdigit((unsigned char) name[1])) {
+                emit(c8_condition::PUSH_V, std::stoi(name.substr(1), nullptr, 16));
+            } else if(name == "I") {
+                emit(c8_condition::PUSH_I);
+            } else if(name == "PC") {
+                emit(c8_condition::PUSH_PC);
+            } else if(name == "SP") {
+                emit(c8_condition::PUSH_SP);
+            } else if(name == "DT") {
+                emit(c8_condition::PUSH_DT);
+            } else if(name == "ST") {
+                emit(c8_condition::PUSH_ST);
+            } else if(name == "K") {
+                emit(c8_condition::PUSH_K);
+            } else {
+                position = start;
+                return fail(name.empty() ? "expected a value" : "unknown register '" + name + "'");
+            }
+            return true;
+        }
+    };
+
+    bool c8_condition::compile(const std::string &expression, std::string &error) {
+        c8_condition_parser parser(expression, *this);
+        if(!parser.parse()) {
+            error = parser.error;
+            code.clear();
+            return false;
+        }
+        source = expression;
+        return true;
+    }
+
+    bool c8_condition::evaluate(const c8_registers &r) const {
+        // expressions typed into the debugger are tiny, but don't trust that
+        int32_t smallStack[32];
+        std::vector<int32_t> bigStack;
+        int32_t *stack = smallStack;
+        if(maxDepth > 32) {
+            bigStack.resize(maxDepth);
+            stack = bigStack.data();
+        }
+
+        int top = -1;
+        for(const instruction &in : code) {
+            switch(in.op) {
+                case PUSH_CONST: stack[++top] = in.arg; break;
+                case PUSH_V: stack[++top] = r.v[in.arg]; break;
+                case PUSH_I: stack[++top] = r.I; break;
+                case PUSH_PC: stack[++top] = r.pc; break;
+                case PUSH_SP: stack[++top] = r.sp; break;
+                case PUSH_DT: stack[++top] = r.dt; break;
+                case PUSH_ST: stack[++top] = r.st; break;
+                case PUSH_K: stack[++top] = r.lastKey; break;
+                case NOT: stack[top] = !stack[top]; break;
+                case NEG: stack[top] = -stack[top]; break;
+                case ADD: top--; stack[top] = stack[top] + stack[top+1]; break;
+                case SUB: top--; stack[top] = stack[top] - stack[top+1]; break;
+                case AND: top--; stack[top] = stack[top] & stack[top+1]; break;
+                case XOR: top--; stack[top] = stack[top] ^ stack[top+1]; break;
+                case OR: top--; stack[top] = stack[top] | stack[top+1]; break;
+                case EQ: top--; stack[top] = stack[top] == stack[top+1]; break;
+                case NE: top--; stack[top] = stack[top] != stack[top+1]; break;
+                case LT: top--; stack[top] = stack[top] < stack[top+1]; break;
+                case LE: top--; stack[top] = stack[top] <= stack[top+1]; break;
+                case GT: top--; stack[top] = stack[top] > stack[top+1]; break;
+                case GE: top--; stack[top] = stack[top] >= stack[top+1]; break;
+                case LAND: top--; stack[top] = stack[top] && stack[top+1]; break;
+                case LOR: top--; stack[top] = stack[top] || stack[top+1]; break;
+            }
+        }
+        return top >= 0 && stack[top] != 0;
+    }
+
+    void c8_breakpoints::rearm() {
+        isArmed = addresses.any() || nextOpcodeMask != 0 || !conditions.empty() || !watchpoints.empty();
+    }
+
+    void c8_breakpoints::toggleAddress(uint16_t addr) {
+        addresses.flip(addr);
+        rearm();
+    }
+
+    void c8_breakpoints::breakOnNext(uint64_t opcodeMask) {
+        nextOpcodeMask = opcodeMask;
+        rearm();
+    }
+
+    void c8_breakpoints::addCondition(const c8_condition &condition) {
+        conditions.push_back(condition);
+        rearm();
+    }
+
+    void c8_breakpoints::addWatchpoint(const c8_watchpoint &watchpoint) {
+        watchpoints.push_back(watchpoint);
+        rearm();
+    }
+
+    void c8_breakpoints::removeCondition(size_t i) {
+        conditions.erase(conditions.begin() + i);
+        rearm();
+    }
+
+    void c8_breakpoints::removeWatchpoint(size_t i) {
+        watchpoints.erase(watchpoints.begin() + i);
+        rearm();
+    }
+
+    void c8_breakpoints::clear() {
+        addresses.reset();
+        nextOpcodeMask = 0;
+        conditions.clear();
+        watchpoints.clear();
+        rearm();
+    }
+
+    void c8_breakpoints::prime(const c8_state &state) {
+        for(c8_condition &condition : conditions) {
+            condition.held = condition.evaluate(state);
+        }
+    }
+
+    bool c8_breakpoints::check(const c8_state &state) {
+        // every condition is evaluated before anything else can break, so each always knows whether it held before
+        // the next instruction
+        bool becameTrue = false;
+        for(c8_condition &condition : conditions) {
+            bool holds = condition.evaluate(state);
+            becameTrue |= holds && !condition.held;
+            condition.held = holds;
+        }
+
+        if(state.pc > RAM_SIZE - 2)
+            return false;
+        if(addresses.test(state.pc))
+            return true;
+
+        uint16_t inst = (uint16_t) (state.ram[state.pc] << 8) | (uint16_t) (state.ram[state.pc + 1]);
+        if(nextOpcodeMask & opcodeBit(classifyOpcode(inst))) {
+            nextOpcodeMask = 0;
+            rearm();
+            return true;
+        }
+        if(becameTrue)
+            return true;
+
+        if(!watchpoints.empty()) {
+            c8_memory_access access = memoryAccessOf(inst, state.I, state.planes);
+            for(const c8_watchpoint &w : watchpoints) {
+                if(w.read && access.readStart < w.end && w.start < access.readEnd)
+                    return true;
+                if(w.write && access.writeStart < w.end && w.start < access.writeEnd)
+                    return true;
+            }
+        }
+        return false;
+    }
+}
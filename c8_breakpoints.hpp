@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "c8_constants.hpp"
+#include "c8_opcodes.hpp"
+#include "c8_state.hpp"
+
+namespace yac8 {
+    /**
+     * A boolean expression over the registers, compiled to a small stack bytecode so it's cheap to evaluate every
+     * cycle. Supports V0-VF, I, PC, SP, DT, ST, K (last key), decimal and 0x hex literals, parentheses, and the C
+     * operators ! - + & ^ | == != < <= > >= && ||. For example: `V3 == 0x10 && I > 0x300`
+     * As a breakpoint it's edge-triggered: it breaks when it becomes true, not on every instruction while it stays so.
+     */
+    class c8_condition {
+        enum opcode : uint8_t {
+            PUSH_CONST, PUSH_V, PUSH_I, PUSH_PC, PUSH_SP, PUSH_DT, PUSH_ST, PUSH_K,
+            NOT, NEG, ADD, SUB, AND, XOR, OR, EQ, NE, LT, LE, GT, GE, LAND, LOR
+        };
+        struct instruction {
+            opcode op;
+            int32_t arg;
+        };
+
+        std::vector<instruction> code;
+        int maxDepth = 0;
+
+        friend class c8_condition_parser;
+    public:
+        std::string source;
+        // whether it held before the last instruction c8_breakpoints checked
+        bool held = false;
+
+        // returns false and describes the problem in `error` if `expression` doesn't parse
+        bool compile(const std::string &expression, std::string &error);
+        bool evaluate(const c8_registers &registers) const;
+    };
+
+    /**
+     * A memory range to break on when an instruction is about to read and/or write it.
+     */
+    struct c8_watchpoint {
+        uint16_t start = 0, end = 0; // [start, end)
+        bool read = false, write = true;
+    };
+
+    /**
+     * Everything the debugger can break on. The emulation thread only calls check() when armed() is true,
+     * so execution with nothing set pays a single branch per cycle.
+     */
+    class c8_breakpoints {
+        std::bitset<RAM_SIZE> addresses;
+        // break before the next instruction in any of these classes, then forget them
+        uint64_t nextOpcodeMask = 0;
+        std::vector<c8_condition> conditions;
+        std::vector<c8_watchpoint> watchpoints;
+        bool isArmed = false;
+
+        void rearm();
+    public:
+        bool armed() const { return isArmed; }
+
+        bool hasAddress(uint16_t addr) const { return addresses.test(addr); }
+        void toggleAddress(uint16_t addr);
+        void breakOnNext(uint64_t opcodeMask);
+
+        void addCondition(const c8_condition &condition);
+        void addWatchpoint(const c8_watchpoint &watchpoint);
+        const std::vector<c8_condition> &getConditions() const { return conditions; }
+        const std::vector<c8_watchpoint> &getWatchpoints() const { return watchpoints; }
+        void removeCondition(size_t i);
+        void removeWatchpoint(size_t i);
+        void clear();
+
+        // returns true if execution should stop before the instruction at PC
+        bool check(const c8_state &state);
+        // records whether each condition holds in `state` without breaking, for when the machine got there without
+        // executing its way there (a restored snapshot, a rewind), so the next check() only sees edges from there
+        void prime(const c8_state &state);
+    };
+}
@@ -7,11 +7,22 @@
 namespace yac8 {
     const int
         V_REGISTERS_SIZE = 0x10,
-        RAM_SIZE = 0x1000, // 4096
+        RAM_SIZE = 0x10000, // 65536, the XO-CHIP address space. Chip-8 programs only use the first 4096
         PROGRAM_OFFSET = 0x200, // 512
         STACK_SIZE = 0x10, // 16
         WINDOW_WIDTH = 64,
-        WINDOW_HEIGHT = 32;
+        WINDOW_HEIGHT = 32,
+        // SUPER-CHIP high resolution mode
+        HIRES_WIDTH = 128,
+        HIRES_HEIGHT = 64,
+        // where the SUPER-CHIP 8x10 font starts, right after the 4x5 one
+        BIG_TYPOGRAPHY_OFFSET = 0x50,
+        // processor speeds, in cycles per second, the emulator can be set to
+        MIN_SPEED = 1,
+        MAX_SPEED = 4000,
+        // RAM is shared and watched for writes in pages of this size
+        PAGE_SIZE = 0x100, // 256
+        PAGE_COUNT = RAM_SIZE / PAGE_SIZE; // 256
 
     const uint16_t default_typography_buffer[80] = {
         0xF0,0x90,0x90,0x90,0xF0,
@@ -31,4 +42,24 @@ namespace yac8 {
         0xF0,0x80,0xF0,0x80,0xF0,
         0xF0,0x80,0xF0,0x80,0x80
     };
-}
\ No newline at end of file
+
+    // SUPER-CHIP 8x10 digits for Fx30 (16 characters * 10 bytes per character)
+    const uint16_t default_big_typography_buffer[160] = {
+        0x3C,0x7E,0xE7,0xC3,0xC3,0xC3,0xC3,0xE7,0x7E,0x3C,
+        0x18,0x38,0x58,0x18,0x18,0x18,0x18,0x18,0x18,0x3C,
+        0x3E,0x7F,0xC3,0x06,0x0C,0x18,0x30,0x60,0xFF,0xFF,
+        0x3C,0x7E,0xC3,0x03,0x0E,0x0E,0x03,0xC3,0x7E,0x3C,
+        0x06,0x0E,0x1E,0x36,0x66,0xC6,0xFF,0xFF,0x06,0x06,
+        0xFF,0xFF,0xC0,0xC0,0xFC,0xFE,0x03,0xC3,0x7E,0x3C,
+        0x3E,0x7C,0xE0,0xC0,0xFC,0xFE,0xC3,0xC3,0x7E,0x3C,
+        0xFF,0xFF,0x03,0x06,0x0C,0x18,0x30,0x60,0x60,0x60,
+        0x3C,0x7E,0xC3,0xC3,0x7E,0x7E,0xC3,0xC3,0x7E,0x3C,
+        0x3C,0x7E,0xC3,0xC3,0x7F,0x3F,0x03,0x03,0x3E,0x7C,
+        0x3C,0x7E,0xC3,0xC3,0xFF,0xFF,0xC3,0xC3,0xC3,0xC3,
+        0xFC,0xFE,0xC3,0xC3,0xFE,0xFE,0xC3,0xC3,0xFE,0xFC,
+        0x3C,0x7E,0xC3,0xC0,0xC0,0xC0,0xC0,0xC3,0x7E,0x3C,
+        0xFC,0xFE,0xC3,0xC3,0xC3,0xC3,0xC3,0xC3,0xFE,0xFC,
+        0xFF,0xFF,0xC0,0xC0,0xFC,0xFC,0xC0,0xC0,0xFF,0xFF,
+        0xFF,0xFF,0xC0,0xC0,0xFC,0xFC,0xC0,0xC0,0xC0,0xC0
+    };
+}
@@ -7,31 +7,40 @@
 #include <sstream>
 #include <iomanip>
 
+#include "c8_quirks.hpp"
+#include "c8_state.hpp"
+
 namespace yac8 {
 
     #define h(N) std::setfill('0') << std::setw(N) << std::right << std::hex
     #define hx(N) "0x" << h(N)
 
+    // an operand, followed by its value when there are registers to show it from
+    #define Z(z, vz)    str << z; if(regs) str << "=" << h(2) << vz
+    #define X           Z("V" << h(1) << +x, +regs->v[x])
+    #define Y           Z("V" << h(1) << +y, +regs->v[y])
+
     #define L(inst)     str << inst; break;
     #define La(inst)    str << inst << "\t" << "adr=" << h(3) << +addr; break;
-    #define Lxb(inst)   str << inst << "\t" << "V" << h(1) << +x << "=" << h(2) << +vx << ", " << h(2) << +byte; break;
-    #define Lxy(inst)   str << inst << "\t" << "V" << h(1) << +x << "=" << h(2) << +vx << ", " << "V" << +y << "=" << h(2) << +vy; break;
-    #define Lxyn(inst)  str << inst << "\t" << "V" << h(1) << +x << "=" << h(2) << +vx << ", " << "V" << +y << "=" << h(2) << +vy << ", " << h(1) << +nibble; break;
-    #define Lx(inst)    str << inst << "\t" << "V" << h(1) << +x << "=" << h(2) << +vx; break;
-    #define Lxz(inst, z, vz)   str << inst << "\t" << "V" << h(1) << +x << "=" << h(2) << +vx << ", " << z << "=" << h(2) << vz; break;
-    #define Lzx(inst, z, vz)   str << inst << "\t" << z << "=" << h(2) << vz << ", " << "V" << h(1) << +x << "=" << h(2) << +vx; break;
+    #define Lxb(inst)   str << inst << "\t"; X; str << ", " << h(2) << +byte; break;
+    #define Lxy(inst)   str << inst << "\t"; X; str << ", "; Y; break;
+    #define Lxyn(inst)  str << inst << "\t"; X; str << ", "; Y; str << ", " << h(1) << +nibble; break;
+    #define Lx(inst)    str << inst << "\t"; X; break;
+    #define Lxz(inst, z, vz)   str << inst << "\t"; X; str << ", "; Z(z, vz); break;
+    #define Lzx(inst, z, vz)   str << inst << "\t"; Z(z, vz); str << ", "; X; break;
     #define L0a(inst)   str << inst << "\t" << "V0" << "adr=" << h(3) << +addr; break;
 
-    std::string print_instruction(const int pc, const c8_state & state, const c8_quirks & quirks) {
-        if(pc < PROGRAM_OFFSET || pc >= RAM_SIZE)
+    // describes the instruction at `pc` in `ram`. With `regs`, every register operand is followed by its value
+    inline std::string print_instruction(const int pc, const uint8_t *ram, const c8_registers *regs,
+                                         const c8_quirks & quirks) {
+        if(pc < PROGRAM_OFFSET || pc > RAM_SIZE - 2)
             return "???";
 
         // process instructions
-        uint16_t instruction = (uint16_t)(state.ram[pc] << 8) | (uint16_t)(state.ram[pc+1]);
+        uint16_t instruction = (uint16_t)(ram[pc] << 8) | (uint16_t)(ram[pc+1]);
 
         // convenient aliases, used by A = {3,4,5,6,7,8,9,C,D,E}
         uint8_t x = static_cast<uint8_t>((instruction & 0x0F00) >> 8), y = static_cast<uint8_t>((instruction & 0x00F0) >> 4);
-        const uint8_t &vx = state.v[x], &vy = state.v[y];
 
         uint16_t addr = instruction & 0x0FFF;
         uint8_t byte = instruction & 0x00FF;
@@ -46,13 +55,30 @@ namespace yac8 {
                 switch(instruction & 0x00FF) {
                     case 0x00E0: L("CLS");
                     case 0x00EE: L("RET");
+                    case 0x00FB: L("SCR");
+                    case 0x00FC: L("SCL");
+                    case 0x00FD: L("EXIT");
+                    case 0x00FE: L("LOW");
+                    case 0x00FF: L("HIGH");
                 }
+                if((instruction & 0x00F0) == 0x00C0)
+                    str << "SCD " << "\t" << h(1) << +nibble;
+                if((instruction & 0x00F0) == 0x00D0)
+                    str << "SCU " << "\t" << h(1) << +nibble;
                 break;
             case 0x1000: La("JP  ");
             case 0x2000: La("CALL");
             case 0x3000: Lxb("SE  ");
             case 0x4000: Lxb("SNE ");
-            case 0x5000: Lxy("SE  ");
+            case 0x5000:
+                switch(instruction & 0x000F) {
+                    case 0x0002: Lxy("SAVE");
+                        // 5xy2 - LD [I], Vx-Vy
+                    case 0x0003: Lxy("LOAD");
+                        // 5xy3 - LD Vx-Vy, [I]
+                    default: Lxy("SE  ");
+                }
+                break;
             case 0x6000: Lxb("LD  ");
             case 0x7000: Lxb("ADD ");
             case 0x8000:
@@ -93,31 +119,52 @@ namespace yac8 {
                 break;
             case 0xF000:
                 switch(instruction & 0x00FF) {
-                    case 0x0007: Lxz("LD  ", "DT", +state.dt);
+                    case 0x0000:
+                        // F000 nnnn - LD I, long addr
+                        if(x == 0 && pc <= RAM_SIZE - 4)
+                            str << "LD  " << "\t" << "I, adr=" << h(4) << (ram[pc+2] << 8 | ram[pc+3]);
+                        break;
+                    case 0x0001: str << "PLN " << "\t" << h(1) << +x; break;
+                        // Fn01 - PLANE n
+                    case 0x0002: L("AUD ");
+                        // F002 - AUDIO
+                    case 0x0007: Lxz("LD  ", "DT", +regs->dt);
                         // Fx07 - LD Vx, DT
                     case 0x000A: Lxz("LD  ", "K", "?");
                         // Fx0A - LD Vx, K
-                    case 0x0015: Lzx("LD  ", "DT", +state.dt);
+                    case 0x0015: Lzx("LD  ", "DT", +regs->dt);
                         // Fx15 - LD DT, Vx
-                    case 0x0018: Lzx("LD  ", "ST", +state.st);
+                    case 0x0018: Lzx("LD  ", "ST", +regs->st);
                         // Fx18 - LD ST, Vx
-                    case 0x001E: Lzx("ADD ", "I", hx(3) << +state.I);
+                    case 0x001E: Lzx("ADD ", "I", hx(3) << +regs->I);
                         // Fx1E - ADD I, Vx
                     case 0x0029: Lzx("LD  ", "F", "?");
                         // Fx29 - LD F, Vx
+                    case 0x0030: Lzx("LD  ", "HF", "?");
+                        // Fx30 - LD HF, Vx
                     case 0x0033: Lzx("LD  ", "B", "?");
                         // Fx33 - LD B, Vx
-                    case 0x0055: Lzx("LD  ", "I", +state.I);
+                    case 0x003A: Lx("PTCH");
+                        // Fx3A - PITCH Vx
+                    case 0x0055: Lzx("LD  ", "I", +regs->I);
                         // Fx55 - LD I, Vx
-                    case 0x0065: Lxz("LD  ", "I", +state.I);
+                    case 0x0065: Lxz("LD  ", "I", +regs->I);
                         // Fx65 - LD Vx, I
+                    case 0x0075: Lzx("LD  ", "R", "?");
+                        // Fx75 - LD R, Vx
+                    case 0x0085: Lxz("LD  ", "R", "?");
+                        // Fx85 - LD Vx, R
                 }
                 break;
         }
         return str.str();
     }
 
-    std::string print_register(int i) {
+    inline std::string print_instruction(const int pc, const c8_state & state, const c8_quirks & quirks) {
+        return print_instruction(pc, state.ram, &state, quirks);
+    }
+
+    inline std::string print_register(int i) {
         std::ostringstream str{};
         str << hx(2) << +i;
         return str.str();
@@ -0,0 +1,111 @@
+#include "c8_disassembly.hpp"
+#include "c8_debug.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace yac8 {
+    c8_disassembly::c8_disassembly() {
+        std::memset(image, 0, sizeof(image));
+        std::memset(calls, 0, sizeof(calls));
+        std::memset(jumps, 0, sizeof(jumps));
+        std::memset(seenWrites, 0, sizeof(seenWrites));
+        for(int address = PROGRAM_OFFSET; address < RAM_SIZE; address += 2) {
+            disassemble(address);
+        }
+    }
+
+    void c8_disassembly::setEnd(int address) {
+        if(address > RAM_SIZE)
+            address = RAM_SIZE;
+        end = address > PROGRAM_OFFSET ? address : PROGRAM_OFFSET;
+    }
+
+    int c8_disassembly::refresh(const c8_state &state, c8_quirks q) {
+        int refreshed = 0;
+        if(packQuirks(q) != packQuirks(quirks)) {
+            quirks = q;
+            // only the shifts are described differently under other quirks, so only their lines are redone
+            for(int address = PROGRAM_OFFSET; address < RAM_SIZE; address += 2) {
+                uint16_t instruction = (uint16_t) (image[address] << 8 | image[address + 1]);
+                if((instruction & 0xF00F) == 0x8006 || (instruction & 0xF00F) == 0x800E) {
+                    disassemble(address);
+                    refreshed++;
+                }
+            }
+        }
+
+        // only pages written since the last refresh can differ from the image, unless RAM was replaced as a whole
+        bool reloaded = !synced || state.reloads != seenReloads;
+        synced = true;
+        seenReloads = state.reloads;
+        for(int page = PROGRAM_OFFSET / PAGE_SIZE; page < PAGE_COUNT; page++) {
+            if(!reloaded && state.pageWrites[page] == seenWrites[page])
+                continue;
+            seenWrites[page] = state.pageWrites[page];
+            int start = page * PAGE_SIZE;
+            if(std::memcmp(image + start, state.ram + start, PAGE_SIZE) == 0)
+                continue;
+            for(int address = start; address < start + PAGE_SIZE; address += 2) {
+                if(image[address] == state.ram[address] && image[address + 1] == state.ram[address + 1])
+                    continue;
+                reference((uint16_t) (image[address] << 8 | image[address + 1]), -1);
+                image[address] = state.ram[address];
+                image[address + 1] = state.ram[address + 1];
+                reference((uint16_t) (image[address] << 8 | image[address + 1]), 1);
+                disassemble(address);
+                refreshed++;
+                // an F000 before this word shows it as its long address
+                if(address - 2 >= PROGRAM_OFFSET && image[address - 2] == 0xF0 && image[address - 1] == 0x00) {
+                    disassemble(address - 2);
+                    refreshed++;
+                }
+            }
+        }
+        return refreshed;
+    }
+
+    void c8_disassembly::reference(uint16_t instruction, int delta) {
+        uint16_t target = instruction & 0x0FFF;
+        switch(instruction & 0xF000) {
+            case 0x1000:
+                jumps[target] += delta;
+                break;
+            case 0x2000:
+                calls[target] += delta;
+                break;
+        }
+    }
+
+    bool c8_disassembly::label(int line, char *out, int size) const {
+        int address = addressOf(line);
+        for(int a = address; a < address + 2 && a < RAM_SIZE; a++) {
+            if(calls[a] != 0) {
+                std::snprintf(out, size, "sub_%03x", a);
+                return true;
+            }
+            if(jumps[a] != 0) {
+                std::snprintf(out, size, "loc_%03x", a);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void c8_disassembly::disassemble(int address) {
+        // the listing is drawn in one font, so the columns are spaced out rather than tabbed
+        std::string text = print_instruction(address, image, nullptr, quirks);
+        char *out = lines[lineOf(address)];
+        int n = 0;
+        for(char c : text) {
+            if(c == '\t') {
+                for(int i = 0; i < 2 && n < DISASSEMBLY_TEXT_SIZE - 1; i++) {
+                    out[n++] = ' ';
+                }
+            } else if(n < DISASSEMBLY_TEXT_SIZE - 1) {
+                out[n++] = c;
+            }
+        }
+        out[n] = '\0';
+    }
+}
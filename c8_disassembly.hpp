@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "c8_constants.hpp"
+#include "c8_quirks.hpp"
+#include "c8_state.hpp"
+
+namespace yac8 {
+    const int DISASSEMBLY_TEXT_SIZE = 40;
+
+    /**
+     * A disassembly of the whole program area, one line per instruction-aligned word, in print_instruction's words
+     * but without register values. It keeps a copy of the RAM it was built from, and refresh() only looks at the
+     * pages c8_state::pageWrites says were written since, so it costs next to nothing to keep up to date every
+     * frame. Also tracks which addresses are call and jump targets, for labels.
+     */
+    class c8_disassembly {
+        uint8_t image[RAM_SIZE];
+        char lines[(RAM_SIZE - PROGRAM_OFFSET) / 2][DISASSEMBLY_TEXT_SIZE];
+        // how many instructions currently call or jump to each address
+        uint16_t calls[RAM_SIZE];
+        uint16_t jumps[RAM_SIZE];
+        c8_quirks quirks;
+        int end = PROGRAM_OFFSET;
+        // state.pageWrites and state.reloads as of the last refresh; until the first one, every page is compared
+        uint32_t seenWrites[PAGE_COUNT];
+        uint32_t seenReloads = 0;
+        bool synced = false;
+
+        void disassemble(int address);
+        void reference(uint16_t instruction, int delta);
+    public:
+        c8_disassembly();
+
+        // re-disassembles what changed in `state` since the last refresh, and returns how many lines that was
+        int refresh(const c8_state &state, c8_quirks quirks);
+        // the listing covers the loaded program, and grows if the program counter runs past it
+        void setEnd(int address);
+
+        int lineCount() const {
+            return (end - PROGRAM_OFFSET + 1) / 2;
+        }
+        int lineOf(int address) const {
+            return (address - PROGRAM_OFFSET) / 2;
+        }
+        int addressOf(int line) const {
+            return PROGRAM_OFFSET + line * 2;
+        }
+        const char *text(int line) const {
+            return lines[line];
+        }
+
+        // writes the label of any call or jump target inside the line into `out`, returns false if there's none
+        bool label(int line, char *out, int size) const;
+    };
+}
@@ -0,0 +1,129 @@
+#include "c8_display.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace yac8 {
+    void c8_display::clear(uint8_t planes) {
+        for(int p = 0; p < PLANES; p++) {
+            if(planes & (1 << p))
+                std::memset(rows[p], 0, sizeof(rows[p]));
+        }
+    }
+
+    void c8_display::setHires(bool enabled) {
+        hires = enabled;
+        clear();
+    }
+
+    void c8_display::drawSprite(const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t planes, uint8_t &VF,
+                                bool wrap) {
+        VF = 0;
+        const int w = width(), h = height(), words = w / 64;
+        x = x % w;
+        y = y % h;
+
+        // a 16x16 sprite is two bytes per row
+        const bool wide = n == 0;
+        const int spriteRows = wide ? 16 : n;
+        const int planeBytes = wide ? 32 : n;
+        const int word = x >> 6, shift = x & 63;
+        // the word the part of a row past `word` lands in, or -1 if it falls off the right edge
+        const int spill = word + 1 < words ? word + 1 : (wrap ? 0 : -1);
+
+        // every selected plane is drawn in the same pass over the rows, each from its own run of sprite bytes
+        int drawn[PLANES];
+        int drawnCount = 0;
+        for(int p = 0; p < PLANES; p++) {
+            if(planes & (1 << p))
+                drawn[drawnCount++] = p;
+        }
+
+        uint64_t collided = 0;
+        for(int j = 0; j < spriteRows; j++) {
+            int py = y + j;
+            if(py >= h) {
+                if(!wrap)
+                    break;
+                py -= h;
+            }
+
+            for(int k = 0; k < drawnCount; k++) {
+                // left-align the sprite row in a word, then split it across the two words it covers
+                const uint8_t *data = sprite + k * planeBytes;
+                uint64_t bits = wide ? (uint64_t) (data[2 * j] << 8 | data[2 * j + 1]) << 48 : (uint64_t) data[j] << 56;
+                uint64_t *row = rows[drawn[k]][py];
+                uint64_t left = bits >> shift;
+                collided |= row[word] & left;
+                row[word] ^= left;
+                if(shift != 0 && spill >= 0) {
+                    uint64_t right = bits << (64 - shift);
+                    collided |= row[spill] & right;
+                    row[spill] ^= right;
+                }
+            }
+        }
+        VF = collided != 0 ? 1 : 0;
+    }
+
+    void c8_display::scroll(int dx, int dy, uint8_t planes) {
+        const int h = height(), words = width() / 64;
+        for(int p = 0; p < PLANES; p++) {
+            if(!(planes & (1 << p)))
+                continue;
+            uint64_t (*plane)[ROW_WORDS] = rows[p];
+            if(dy > 0) {
+                dy = std::min(dy, h);
+                std::memmove(plane[dy], plane[0], (h - dy) * sizeof(plane[0]));
+                std::memset(plane[0], 0, dy * sizeof(plane[0]));
+            } else if(dy < 0) {
+                int up = std::min(-dy, h);
+                std::memmove(plane[0], plane[up], (h - up) * sizeof(plane[0]));
+                std::memset(plane[h - up], 0, up * sizeof(plane[0]));
+            }
+            if(dx > 0) {
+                for(int y = 0; y < h; y++) {
+                    for(int i = words - 1; i > 0; i--) {
+                        plane[y][i] = plane[y][i] >> dx | plane[y][i - 1] << (64 - dx);
+                    }
+                    plane[y][0] >>= dx;
+                }
+            } else if(dx < 0) {
+                int left = -dx;
+                for(int y = 0; y < h; y++) {
+                    for(int i = 0; i < words - 1; i++) {
+                        plane[y][i] = plane[y][i] << left | plane[y][i + 1] >> (64 - left);
+                    }
+                    plane[y][words - 1] <<= left;
+                }
+            }
+        }
+    }
+
+    uint64_t c8_display::hash(uint64_t h) const {
+        const int w = width(), rowsUsed = height();
+        for(int y = 0; y < rowsUsed; y++) {
+            for(int x = 0; x < w; x++) {
+                h = (h ^ pixel(x, y)) * 0x100000001b3ULL;
+            }
+        }
+        return h;
+    }
+
+    void decayPhosphor(const c8_display &display, uint8_t intensity[HIRES_WIDTH * HIRES_HEIGHT * c8_display::PLANES],
+                       float factor) {
+        const int scale = display.hires ? 0 : 1;
+        for(int y = 0; y < HIRES_HEIGHT; y++) {
+            uint8_t *out = intensity + y * HIRES_WIDTH * c8_display::PLANES;
+            for(int x = 0; x < HIRES_WIDTH; x++) {
+                for(int p = 0; p < c8_display::PLANES; p++) {
+                    uint8_t &value = out[x * c8_display::PLANES + p];
+                    if(display.lit(p, x >> scale, y >> scale)) value = 255;
+                    else {
+                        value *= factor;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "c8_constants.hpp"
+#include "c8_hash.hpp"
+
+namespace yac8 {
+    /**
+     * The Chip-8 framebuffer, and the hardware operations that modify it.
+     * Rows are packed into 64-bit words, most significant bit leftmost, so sprites are drawn and the screen is
+     * scrolled a word at a time. In the default 64x32 mode each row is the first word of the first 32 rows; the
+     * SUPER-CHIP 128x64 mode uses both words of all 64.
+     * XO-CHIP adds a second bitplane, so a pixel is one of four colors. Operations only touch the planes in their
+     * `planes` mask (bit 0 is plane 0); plain Chip-8 and SUPER-CHIP programs only ever select plane 0.
+     */
+    class c8_display {
+    public:
+        static const int ROW_WORDS = HIRES_WIDTH / 64;
+        static const int PLANES = 2;
+        static const uint8_t ALL_PLANES = (1 << PLANES) - 1;
+
+        uint64_t rows[PLANES][HIRES_HEIGHT][ROW_WORDS] = {{{0}}};
+        bool hires = false;
+
+        int width() const { return hires ? HIRES_WIDTH : WINDOW_WIDTH; }
+        int height() const { return hires ? HIRES_HEIGHT : WINDOW_HEIGHT; }
+        bool lit(int plane, int x, int y) const { return (rows[plane][y][x >> 6] >> (63 - (x & 63))) & 1; }
+        // the color of a pixel, one bit per plane
+        uint8_t pixel(int x, int y) const { return (uint8_t) (lit(0, x, y) | lit(1, x, y) << 1); }
+
+        void clear(uint8_t planes = ALL_PLANES);
+        // switches between 64x32 and 128x64, clearing every plane
+        void setHires(bool enabled);
+        // XORs a sprite onto the selected planes at (x, y), setting VF on collision in any of them. Each plane
+        // takes n bytes of `sprite` in turn, or 32 when n = 0, which is a 16x16 sprite (SUPER-CHIP Dxy0)
+        void drawSprite(const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t planes, uint8_t &VF, bool wrap);
+        // moves the selected planes by (dx, dy) pixels of the current resolution, filling with unlit pixels. Only
+        // the SUPER-CHIP and XO-CHIP scrolls are supported: any dy with dx = 0, or dx of +/-4 with dy = 0
+        void scroll(int dx, int dy, uint8_t planes = ALL_PLANES);
+
+        // FNV-1a of one pixel() byte per pixel of the current resolution, row-major. Without a second plane
+        // that's the bytes of a bool image, which is what the framebuffer used to be
+        uint64_t hash(uint64_t h = FNV_OFFSET_BASIS) const;
+    };
+
+    // simulates a phosphorescent screen: lit pixels glow at full intensity, unlit ones fade by `factor` per call.
+    // `intensity` is 128x64 with one byte per plane per pixel, interleaved, so 64x32 pixels are doubled
+    void decayPhosphor(const c8_display &display, uint8_t intensity[HIRES_WIDTH * HIRES_HEIGHT * c8_display::PLANES],
+                       float factor);
+}
@@ -4,20 +4,34 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <random>
 #include <thread>
 #include <string>
-#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <Windows.h>
 #include <mutex>
+#include <numeric>
+#include <vector>
 
 #include "imgui/imgui.h"
 #include "imgui/backends/imgui_impl_sdl.h"
 #include "imgui/backends/imgui_impl_opengl3.h"
 
 #include "c8_debug.hpp"
+#include "c8_disassembly.hpp"
+#include "c8_hash.hpp"
 #include "c8_noisemaker.hpp"
+#include "c8_quirk_detector.hpp"
+#include "c8_rom_library.hpp"
+#include "c8_trace_events.hpp"
+#include "c8_write_tracker.hpp"
 
 using std::string;
 
@@ -87,6 +101,8 @@ namespace yac8 {
         "uniform sampler2D tex;\n"
         "uniform vec4 background;\n"
         "uniform vec4 foreground;\n"
+        "uniform vec4 foreground2;\n"
+        "uniform vec4 foreground3;\n"
         "\n"
         "in vec2 texCoord;\n"
         "\n"
@@ -111,84 +127,139 @@ namespace yac8 {
         "\t\t\ttc.y -= 0.5;\n"
         "\t\t\ttc.y *= 1.0 + (dx * CRT_CURVE_AMNTy);\n"
         "\t\t\ttc.y += 0.5;\n"
-        "\t\t\tfloat a = texture(tex, vec2(tc.x, 1.0-tc.y)).r;\n"
+        "\t\t\tvec2 a = texture(tex, vec2(tc.x, 1.0-tc.y)).rg;\n"
+        "\t\t\tvec4 color = mix(mix(background, foreground, a.r), mix(foreground2, foreground3, a.r), a.g);\n"
         "\t\t\tbool b = tc.y > 1.0 || tc.x < 0.0 || tc.x > 1.0 || tc.y < 0.0;\n"
-        "\t\t\tfragColor += float(!b)*(background * float(1.0-a) + foreground * float(a) + sin(tc.y * SCAN_LINE_MULT) * 0.02) / 49.0;\n"
+        "\t\t\tfragColor += float(!b)*(color + sin(tc.y * SCAN_LINE_MULT) * 0.02) / 49.0;\n"
         "\t\t}\n"
         "\t}\n"
         "}";
 
     // emulation to be run on a seperate thread
+    // everything applied to the machine goes to the movie being recorded, and to the rewind history
+    static void record(c8_emulator &emu, const c8_movie_event &event) {
+        emu.recorder.record(event);
+        emu.rewind.record(event);
+    }
+
     void emulationThread(
             std::mutex &state_mutex,
              const bool *running,
              bool *incompatible_flag,
-             c8_emulator & emu,
-             c8_hardware_api & hardware_api,
-             c8_state & state)
+             c8_emulator & emu)
              {
         using clock = std::chrono::high_resolution_clock;
         auto frame_start = clock::now();
+        c8_machine &machine = emu.machine;
+        c8_state &state = machine.state;
+        // the last sound edge sent to the buzzer
+        c8_sound_edge sounding{0, false};
+        // multiplies processorSpeed; only differs from 1 when pacing to the audio clock
+        double pace = 1.0;
+        YAC8_TRACE_THREAD("emulation");
 
         while(*running) {
             // step chip8 simulation if it's time
-            if(clock::now() - frame_start >= std::chrono::microseconds(1000000 / emu.processorSpeed)) {
-                state_mutex.lock();
-
-                // step emulation if it's time. If we encounter a bad instruction, mark the incompatible_flag
-                if(!emu.debug_state.paused || emu.debug_state.step) {
-                    emu.debug_state.step = false;
-                    if(!state.step(hardware_api, emu.quirks)) {
-                        *incompatible_flag = true;
-                    }
+            if(clock::now() - frame_start >= std::chrono::duration<double, std::micro>(1000000.0 / (emu.processorSpeed * pace))) {
+                auto lock_requested = clock::now();
+                {
+                    YAC8_TRACE_SCOPE("wait for state lock");
+                    state_mutex.lock();
                 }
-
-                // if not paused, evaluate any breakpoints
-                if(!emu.debug_state.paused) {
-                    // evaluate regular breakpoints
-                    if(emu.debug_state.breakPoints[state.pc - PROGRAM_OFFSET]) {
-                        emu.debug_state.paused = true;
+                auto lock_acquired = clock::now();
+                uint64_t cycle;
+                {
+                    YAC8_TRACE_SCOPE("emulation slice");
+                    emu.rewind.capture(machine);
+
+                    // pick up settings changed from the UI, recording them at the current guest cycle
+                    if(machine.processorSpeed != emu.processorSpeed) {
+                        machine.processorSpeed = emu.processorSpeed;
+                        record(emu, {machine.cycle, MOVIE_SPEED, 0, (uint16_t)machine.processorSpeed});
                     }
-
-                    uint16_t inst = (uint16_t) (state.ram[state.pc] << 8) | (uint16_t) (state.ram[state.pc + 1]);
-                    uint8_t A = (inst & 0xF000) >> 12;
-
-                    // break on any draw call
-                    if (emu.debug_state.breakDRW && A == 0xD) {
-                        emu.debug_state.breakDRW = false;
-                        emu.debug_state.paused = true;
+                    if(packQuirks(machine.quirks) != packQuirks(emu.quirks)) {
+                        machine.quirks = emu.quirks;
+                        record(emu, {machine.cycle, MOVIE_QUIRKS, 0, packQuirks(machine.quirks)});
+                    }
+                    bool freezeTimers = emu.debug_state.enabled && emu.debug_state.freezeTimers;
+                    if(machine.freezeTimers != freezeTimers) {
+                        machine.freezeTimers = freezeTimers;
+                        record(emu, {machine.cycle, MOVIE_FREEZE_TIMERS, 0, (uint16_t)(freezeTimers ? 1 : 0)});
                     }
 
-                    // break on any JP,CALL,RET, or skip instruction
-                    if (emu.debug_state.breakJP && (
-                            inst == 0x00EE
-                            || A == 0x1
-                            || A == 0x2
-                            || A == 0x3
-                            || A == 0x4
-                            || A == 0x5
-                            || A == 0x9
-                            || A == 0xB
-                    )) {
-                        emu.debug_state.breakJP = false;
-                        emu.debug_state.paused = true;
+                    // apply key events, in the order they happened
+                    c8_movie_event event;
+                    while(emu.input.pop(event)) {
+                        event.cycle = machine.cycle;
+                        if(event.kind == MOVIE_KEY_DOWN) {
+                            machine.press(event.key);
+                        } else {
+                            machine.release(event.key);
+                        }
+                        record(emu, event);
                     }
 
-                    // break on wait for keypress
-                    if(emu.debug_state.breakLDK && (inst&0xF0FF) == 0xF00A) {
-                        emu.debug_state.breakLDK = false;
-                        emu.debug_state.paused = true;
+                    // step emulation if it's time. If we encounter a bad instruction, mark the incompatible_flag
+                    if(!emu.debug_state.paused || emu.debug_state.step) {
+                        emu.debug_state.step = false;
+                        if(!machine.step()) {
+                            *incompatible_flag = true;
+                        }
                     }
 
-                    // break on key skip
-                    if(emu.debug_state.breakSKP && (inst&0xF000) == 0xE000) {
-                        emu.debug_state.breakSKP = false;
-                        emu.debug_state.paused = true;
+                    // if not paused, evaluate any breakpoints. This is the only cost of the debugger when none are set
+                    if(!emu.debug_state.paused && emu.debug_state.breakpoints.armed()) {
+                        if(emu.debug_state.breakpoints.check(state)) {
+                            emu.debug_state.paused = true;
+                        }
+                    }
+                    cycle = machine.cycle;
+
+                    // tell the buzzer when the sound timer starts or stops, or what an XO-CHIP program plays changes
+                    // while it runs. If the queue is full, retry next slice
+                    bool on = state.st != 0;
+                    bool patterned = on && state.audioPatternLoaded;
+                    if(on != sounding.on || patterned != sounding.patterned
+                       || (patterned && (state.pitch != sounding.pitch
+                                         || std::memcmp(state.audioPattern, sounding.pattern, AUDIO_PATTERN_SIZE) != 0))) {
+                        c8_sound_edge edge{cycle, on};
+                        edge.patterned = patterned;
+                        if(patterned) {
+                            edge.pitch = state.pitch;
+                            std::memcpy(edge.pattern, state.audioPattern, AUDIO_PATTERN_SIZE);
+                        }
+                        if(emu.sound.edges.push(edge))
+                            sounding = edge;
                     }
+                    emu.sound.processorSpeed.store(machine.processorSpeed, std::memory_order_relaxed);
+                    emu.sound.cycle.store(cycle, std::memory_order_release);
+
+                    // pacing to the audio clock: a proportional controller nudges the rate so that the sound emulated
+                    // but not yet played stays near the latency target. Over time guest time then advances exactly
+                    // as fast as the device consumes samples, so timers, audio and display can't drift apart
+                    emu.sound.pacing.store(emu.audioPacing, std::memory_order_relaxed);
+                    if(emu.audioPacing) {
+                        double lead = std::max(1.0, emu.audioLatencyMs * machine.processorSpeed / 1000.0);
+                        emu.sound.lead.store((uint64_t) lead, std::memory_order_relaxed);
+                        double ahead = (double) cycle - (double) emu.sound.played.load(std::memory_order_acquire);
+                        pace = std::min(2.0, std::max(0.25, 1.0 - 0.5 * (ahead - lead) / lead));
+                    } else {
+                        pace = 1.0;
+                    }
+
+                    c8_register_snapshot snapshot;
+                    snapshot.registers = state;
+                    snapshot.cycle = cycle;
+                    snapshot.opcode = state.pc <= RAM_SIZE - 2 ? (uint16_t) (state.ram[state.pc] << 8 | state.ram[state.pc + 1]) : 0;
+                    emu.registers.publish(snapshot);
                 }
                 state_mutex.unlock();
 
                 frame_start = clock::now();
+                emu.metrics.recordLock(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(lock_acquired - lock_requested).count(),
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(frame_start - lock_acquired).count(),
+                        cycle);
 
                 // now rest
                 std::this_thread::yield();
@@ -276,116 +347,129 @@ namespace yac8 {
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            // both planes in one texture, plane 0 in red and plane 1 in green
             glTexImage2D(
-                    GL_TEXTURE_2D, 0, GL_R8,
-                    WINDOW_WIDTH, WINDOW_HEIGHT,
-                    0, GL_RED, GL_UNSIGNED_BYTE, decayingPixelBuffer);
+                    GL_TEXTURE_2D, 0, GL_RG8,
+                    HIRES_WIDTH, HIRES_HEIGHT,
+                    0, GL_RG, GL_UNSIGNED_BYTE, decayingPixelBuffer);
         }
 
         // initialize the buzzer
-        c8_noisemaker noisemaker{};
+        c8_noisemaker noisemaker{sound};
 
-        // setup hardware API hooks
-        c8_hardware_api hardware_api{};
-        hardware_api.draw_sprite = [&](const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t &VF) { drawSprite(sprite, x, y, n, VF); };
-        hardware_api.clear_screen = [&]() { clearScreen(); };
-        std::random_device engine;
-        std::uniform_int_distribution<int> dist(0, 0xff);
-        hardware_api.random_byte = [&]()->uint8_t { return (uint8_t)dist(engine); };
+        // each reset gets a fresh seed, so runs only repeat when replaying a movie
+        std::random_device seeder;
 
         // load initial demo rom
         std::vector<char> romData(sizeof(DEMO_ROM));
         std::copy((const char*)DEMO_ROM,(const char*)DEMO_ROM+sizeof(DEMO_ROM), &romData[0]);
-        c8_state state = {};
-        clearScreen();
-        state.loadROM((const uint8_t*)romData.data(), romData.size());
-        state.loadTypography(yac8::default_typography_buffer);
+        c8_state &state = machine.state;
+        machine.quirks = quirks;
+        machine.processorSpeed = processorSpeed;
+        machine.reset((const uint8_t*)romData.data(), romData.size(), seeder());
+
+        // index the bundled ROMs in the background, so they can be switched between instantly
+        c8_rom_library library{};
+        library.scan("c8games");
+        c8_rom currentRom{};
+        currentRom.title = "DEMO";
+        currentRom.hash = fnv1a(romData.data(), romData.size());
+        std::future<c8_rom> pendingRom;
+        // the ROM to load once no load is running, as assigning over a running load's future would block until it
+        // finished. The most recently opened one wins
+        string romToOpen;
+        // quirks being detected for a ROM that has no profile yet
+        std::future<c8_quirks> pendingQuirks;
+        uint64_t pendingQuirksHash = 0;
+        // set to detect the current ROM's quirks as soon as no detection is running. Assigning a new std::async
+        // future over a running one would block the UI until the old one finished
+        bool detectQuirksWanted = false;
 
         // initialize debugging state
-        bool is_noisemaker_testing = false;
         bool incompatible_flag = false;
-
-        // setup timers
-        using clock = std::chrono::high_resolution_clock;
-        auto last_timer_tick = clock::now();
+        char conditionText[128] = "";
+        string conditionError;
+        int watchStart = 0, watchLength = 1;
+        bool watchRead = false, watchWrite = true;
+        std::unique_ptr<c8_profiler> profiler(new c8_profiler());
+        bool profiling = false;
+        std::unique_ptr<c8_opcode_stats> opcodeStats(new c8_opcode_stats());
+        bool countingOpcodes = false;
+        bool showPerformance = false;
+        std::unique_ptr<c8_disassembly> disassembly(new c8_disassembly());
+        char gotoText[8] = "";
+        bool followPC = true;
+        int lastPC = -1;
+        bool showMemory = false;
+        std::unique_ptr<c8_write_tracker> writeTracker(new c8_write_tracker());
+        int memoryHighlightFrames = 60;
 
         // kick off emulation thread and start gameloop
         bool run = true;
         std::mutex state_mutex{};
         std::thread emuThread([&](){
-                    emulationThread(state_mutex, &run, &incompatible_flag, *this, hardware_api, state);
+                    emulationThread(state_mutex, &run, &incompatible_flag, *this);
                 });
 
+        YAC8_TRACE_THREAD("render");
+        auto frame_end = std::chrono::steady_clock::now();
         while(run) {
-            // start/stop audio as needed, depending on state.st
-            if(!is_noisemaker_testing) {
-                if (state.st != 0) {
-                    noisemaker.play();
-                } else {
-                    noisemaker.stop();
-                }
-            }
-
-            // handle timer register ticks on separate interval
-            if(!debug_state.enabled || !debug_state.freezeTimers) {
-                auto timeSinceLastTick = clock::now() - last_timer_tick;
-                const auto tickInterval = std::chrono::milliseconds(1000 / 60);
-                if (timeSinceLastTick > tickInterval) {
-                    if (state.dt != 0)
-                        state.dt -= 1;
-                    if (state.st != 0)
-                        state.st -= 1;
-                    last_timer_tick = clock::now();
-                }
-            }
+            c8_frame_timings frame{};
+            // a consistent copy of the registers for this frame; reading `state` directly would race the emulation thread
+            const c8_register_snapshot snapshot = registers.read();
+            const c8_registers &regs = snapshot.registers;
 
             // state that will determine whether to load/reset ROM at the end of this loop
             bool reset = false;
             bool loadRom = false;
-            string romFilename;
+            bool startRecording = false;
+            bool stepBack = false;
+            bool backToBreakpoint = false;
+            c8_rom romToLoad{};
 
             // handle SDL events for the emulation and ImGui
             ImGuiIO& io = ImGui::GetIO();
-            if(!debug_state.paused)
-                state.lastKey = yac8::NO_LAST_KEY;
             int wheel = 0;
             SDL_Event e;
-            while (SDL_PollEvent(&e))
             {
-                int k = SDL_to_c8_key(e.key.keysym.sym);
-
-                if (e.type == SDL_QUIT) {
-                    run = false;
-                } else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-                    io.DisplaySize.x = static_cast<float>(e.window.data1);
-                    io.DisplaySize.y = static_cast<float>(e.window.data2);
-                } else if (e.type == SDL_MOUSEWHEEL) {
-                    wheel = e.wheel.y;
-                } else if(e.type == SDL_DROPFILE) {
-                    loadRom = true;
-                    romFilename = e.drop.file;
-                } else if(e.type == SDL_KEYUP) {
-                    if(k > 0) {
-                        state.keyStates[k] = false;
-                    }
-                } else if(e.type == SDL_KEYDOWN) {
-                    if(e.key.keysym.sym == SDLK_BACKSPACE) {
-                        reset = true;
-                    } else if(e.key.keysym.sym == SDLK_n) {
-                        debug_state.step = true;
-                    } else if(e.key.keysym.sym == SDLK_SPACE) {
-                        debug_state.paused = !debug_state.paused;
-                    } else if(k > 0) {
-                        if(state.lastKey == yac8::NO_LAST_KEY) {
-                            state.lastKey = k;
+                YAC8_TRACE_SCOPE("poll events");
+                while (SDL_PollEvent(&e))
+                {
+                    int k = SDL_to_c8_key(e.key.keysym.sym);
+
+                    if (e.type == SDL_QUIT) {
+                        run = false;
+                    } else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                        io.DisplaySize.x = static_cast<float>(e.window.data1);
+                        io.DisplaySize.y = static_cast<float>(e.window.data2);
+                    } else if (e.type == SDL_MOUSEWHEEL) {
+                        wheel = e.wheel.y;
+                    } else if(e.type == SDL_DROPFILE) {
+                        romToOpen = e.drop.file;
+                    } else if(e.type == SDL_KEYUP) {
+                        if(k >= 0) {
+                            input.push({0, MOVIE_KEY_UP, (uint8_t)k, 0});
+                        }
+                    } else if(e.type == SDL_KEYDOWN) {
+                        if(e.key.keysym.sym == SDLK_BACKSPACE) {
+                            reset = true;
+                        } else if(e.key.keysym.sym == SDLK_n) {
+                            debug_state.step = true;
+                        } else if(e.key.keysym.sym == SDLK_b) {
+                            stepBack = true;
+                        } else if(e.key.keysym.sym == SDLK_SPACE) {
+                            debug_state.paused = !debug_state.paused;
+                        } else if(k >= 0 && !e.key.repeat) {
+                            input.push({0, MOVIE_KEY_DOWN, (uint8_t)k, 0});
                         }
-                        state.keyStates[k] = true;
                     }
                 }
             }
 
             // Begin ImGui code
+            auto imgui_start = std::chrono::steady_clock::now();
             {
+                YAC8_TRACE_SCOPE("build imgui frame");
                 // handle imgui inputs
                 int mouseX, mouseY;
                 const int buttons = SDL_GetMouseState(&mouseX, &mouseY);
@@ -403,17 +487,44 @@ namespace yac8 {
                 if (ImGui::BeginMainMenuBar()) {
                     if (ImGui::BeginMenu("File")) {
                         if (ImGui::MenuItem("Open")) {
-                            loadRom = true;
-                            romFilename = openROM();
+                            string romFilename = openROM();
+                            if (!romFilename.empty())
+                                romToOpen = romFilename;
                         }
                         if (ImGui::MenuItem("Reset")) {
                             reset = true;
                         }
+                        ImGui::Separator();
+                        if (!recorder.isRecording()) {
+                            if (ImGui::MenuItem("Record Movie")) {
+                                reset = true;
+                                startRecording = true;
+                            }
+                            if (ImGui::IsItemHovered())
+                                ImGui::SetTooltip("Resets the ROM and records all input to a movie file,\nwhich can be replayed with: yac8 --replay <movie> <rom>");
+                        } else if (ImGui::MenuItem("Stop Recording")) {
+                            state_mutex.lock();
+                            recorder.stop(machine.cycle);
+                            state_mutex.unlock();
+                        }
+                        ImGui::EndMenu();
+                    }
+
+                    if (ImGui::BeginMenu("Library")) {
+                        if (library.isScanning()) {
+                            ImGui::TextDisabled("Scanning c8games...");
+                        }
+                        for (const c8_rom &rom : library.list()) {
+                            if (ImGui::MenuItem(rom.title.c_str(), rom.hasProfile ? "profile" : nullptr, rom.hash == currentRom.hash)) {
+                                loadRom = true;
+                                romToLoad = rom;
+                            }
+                        }
                         ImGui::EndMenu();
                     }
 
                     if (ImGui::BeginMenu("Emulation")) {
-                        ImGui::SliderInt("Processor Cycles / Sec", &processorSpeed, 1, MAX_SPEED);
+                        ImGui::SliderInt("Processor Cycles / Sec", &processorSpeed, MIN_SPEED, MAX_SPEED);
                         ImGui::Checkbox("Load/Store Quirk", &quirks.loadStoreQuirk);
                         ImGui::Checkbox("Shift Quirk", &quirks.shiftQuirk);
                         ImGui::Checkbox("Wrapping", &quirks.wrap);
@@ -421,11 +532,51 @@ namespace yac8 {
                         if (ImGui::IsItemHovered())
                             ImGui::SetTooltip(
                                     "Use thread sleep to limit CPU usage.\nTurning this off will make the emulation thread run faster, but makes CPU usage go nuts.");
+                        ImGui::Checkbox("Pace to Audio Clock", &audioPacing);
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Let the sound card's sample rate set the emulation speed, so the timers, audio and display never drift apart");
+                        if (audioPacing)
+                            ImGui::SliderInt("Audio Latency (ms)", &audioLatencyMs, 10, 200);
+                        ImGui::Separator();
+                        if (ImGui::MenuItem("Detect Quirks", nullptr, false, !pendingQuirks.valid())) {
+                            detectQuirksWanted = true;
+                        }
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Run the ROM under every combination of quirks, and pick the one that behaves best");
+                        if (ImGui::MenuItem("Save Settings for this ROM")) {
+                            c8_rom_profile profile{};
+                            profile.quirks = quirks;
+                            profile.processorSpeed = processorSpeed;
+                            library.setProfile(currentRom, profile);
+                        }
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Remember the quirks and processor speed, and apply them whenever %s is loaded", currentRom.title.c_str());
+                        ImGui::Separator();
+                        ImGui::MenuItem("Performance Overlay", nullptr, &showPerformance);
+                        if (!metrics.isLogging()) {
+                            string format;
+                            if (ImGui::MenuItem("Log Metrics to CSV")) {
+                                format = ".csv";
+                            }
+                            if (ImGui::MenuItem("Log Metrics to JSON")) {
+                                format = ".json";
+                            }
+                            if (!format.empty()) {
+                                string metricsFilename = "yac8-metrics-" + std::to_string(std::time(nullptr)) + format;
+                                if (!metrics.startLog(metricsFilename)) {
+                                    std::cerr << "Could not open " << metricsFilename << std::endl;
+                                }
+                            }
+                        } else if (ImGui::MenuItem("Stop Logging Metrics")) {
+                            metrics.stopLog();
+                        }
                         ImGui::EndMenu();
                     }
                     if (ImGui::BeginMenu("Colors")) {
                         ImGui::ColorPicker3("Background Color", bgColor);
                         ImGui::ColorPicker3("Foreground Color", fgColor);
+                        ImGui::ColorPicker3("Plane 2 Color (XO-CHIP)", plane2Color);
+                        ImGui::ColorPicker3("Both Planes Color (XO-CHIP)", bothPlanesColor);
                         ImGui::EndMenu();
                     }
                     if (ImGui::BeginMenu("CRT Screen")) {
@@ -437,23 +588,56 @@ namespace yac8 {
                         ImGui::EndMenu();
                     }
                     if (ImGui::BeginMenu("Buzzer")) {
-                        ImGui::SliderFloat("Volume", &noisemaker.volume, 0.0f, 3.0f);
-                        ImGui::SliderFloat("Pitch", &noisemaker.pitch, 0.1f, 3.0f);
+                        float volume = noisemaker.volume, pitch = noisemaker.pitch;
+                        if (ImGui::SliderFloat("Volume", &volume, 0.0f, 3.0f))
+                            noisemaker.volume = volume;
+                        if (ImGui::SliderFloat("Pitch", &pitch, 0.1f, 3.0f))
+                            noisemaker.pitch = pitch;
                         ImGui::Button("Test");
-                        if (ImGui::IsItemActive()) {
-                            is_noisemaker_testing = true;
-                            noisemaker.play();
-                        } else if (is_noisemaker_testing) {
-                            is_noisemaker_testing = false;
-                            noisemaker.stop();
-                        }
+                        noisemaker.test(ImGui::IsItemActive());
                         ImGui::EndMenu();
                     }
                     if (ImGui::BeginMenu("Debugger")) {
-                        ImGui::Text("Debugger Controls:\n\t[N] Step\n\t[Spacebar] Pause/unpause");
+                        ImGui::Text("Debugger Controls:\n\t[N] Step\n\t[B] Step back\n\t[Spacebar] Pause/unpause");
                         if (ImGui::Button("Toggle Debugger")) {
                             debug_state.enabled = !debug_state.enabled;
                         }
+                        if (ImGui::MenuItem("Memory Viewer", nullptr, &showMemory) && showMemory) {
+                            debug_state.enabled = true;
+                        }
+                        ImGui::Separator();
+                        if (!tracer.isTracing()) {
+                            if (ImGui::MenuItem("Start Execution Trace")) {
+                                string traceFilename = "yac8-" + std::to_string(std::time(nullptr)) + ".c8t";
+                                std::lock_guard<std::mutex> lock(state_mutex);
+                                if (tracer.start(traceFilename, quirks)) {
+                                    machine.setTracer(&tracer);
+                                } else {
+                                    std::cerr << "Could not open " << traceFilename << " for tracing" << std::endl;
+                                }
+                            }
+                            if (ImGui::IsItemHovered())
+                                ImGui::SetTooltip("Record every executed instruction to a .c8t file.\nDecode it with: yac8-tracedump <trace>");
+                        } else if (ImGui::MenuItem("Stop Execution Trace")) {
+                            state_mutex.lock();
+                            machine.setTracer(nullptr);
+                            state_mutex.unlock();
+                            tracer.stop();
+                        }
+#ifdef YAC8_TRACE_EVENTS
+                        if (!trace_events::isCapturing()) {
+                            if (ImGui::MenuItem("Start Timeline Capture")) {
+                                trace_events::start();
+                            }
+                            if (ImGui::IsItemHovered())
+                                ImGui::SetTooltip("Time the emulation, render and audio phases on every thread.\nOpen the capture in chrome://tracing or Perfetto");
+                        } else if (ImGui::MenuItem("Stop Timeline Capture")) {
+                            string timelineFilename = "yac8-timeline-" + std::to_string(std::time(nullptr)) + ".json";
+                            if (!trace_events::stop(timelineFilename)) {
+                                std::cerr << "Could not write " << timelineFilename << std::endl;
+                            }
+                        }
+#endif
                         ImGui::EndMenu();
                     }
                     if (ImGui::BeginMenu("Help")) {
@@ -470,32 +654,59 @@ namespace yac8 {
                     if (incompatible_flag) {
                         ImGui::TextColored(ImVec4{1.0f, 0.5f, 0.5f, 1.0f}, " | Possibly Incompatible ROM");
                     }
+                    if (recorder.isRecording()) {
+                        ImGui::TextColored(ImVec4{1.0f, 0.5f, 0.5f, 1.0f}, " | Recording");
+                    }
                     ImGui::EndMainMenuBar();
                 }
 
+                // where the time goes: the core, the state lock, or rendering
+                if (showPerformance) {
+                    const c8_metrics_sample &m = metrics.latest;
+                    ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10.0f, VIEWPORT_Y_OFFSET + 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+                    ImGui::SetNextWindowBgAlpha(0.35f);
+                    if (ImGui::Begin("Performance", &showPerformance,
+                                     ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing
+                                     | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings)) {
+                        ImGui::Text("cycles/s  %.0f / %d", m.cyclesPerSecond, m.processorSpeed);
+                        ImGui::Text("emulation busy  %.1f%%", 100.0 * m.emulationBusy);
+                        ImGui::Text("lock wait  %.1fus (max %.0fus)", m.lockWaitMicros, m.maxLockWaitMicros);
+                        ImGui::Text("lock hold  %.1fus", m.lockHoldMicros);
+                        ImGui::Separator();
+                        ImGui::Text("frame  %.2fms", m.frameMillis);
+                        ImGui::Text("  imgui    %.2fms", m.imguiMillis);
+                        ImGui::Text("  upload   %.2fms", m.uploadMillis);
+                        ImGui::Text("  crt      %.2fms", m.crtMillis);
+                        ImGui::Text("  swap     %.2fms", m.swapMillis);
+                        ImGui::Separator();
+                        ImGui::Text("audio queued  %.1fms", m.audioQueuedMillis);
+                    }
+                    ImGui::End();
+                }
+
                 if (debug_state.enabled) {
                     if (ImGui::Begin("Debugger", &debug_state.enabled)) {
                         if (incompatible_flag) {
                             ImGui::TextColored(ImVec4{1.0f, 0.0f, 0.0f, 1.0f},
-                                               "Unrecognized instructions detected.\nThis emulator only supports the Cowgod-spec Chip8\nSuper-Chip8, XO-Chip, etc. are not supported.");
+                                               "Unrecognized instructions detected.\nThis emulator supports Chip-8, SUPER-CHIP 1.1 and XO-CHIP;\nother extensions (MegaChip, Chip-8X, etc.) are not supported.");
                         }
                         ImGui::Columns(2);
                         ImGui::TextColored(ImVec4{0.0f, 1.0f, 0.0f, 1.0f}, "%s",
-                                           (string("PC=") + print_register(state.pc)).c_str());
+                                           (string("PC=") + print_register(regs.pc)).c_str());
                         ImGui::TextColored(ImVec4{0.0f, 1.0f, 0.0f, 1.0f}, "%s",
-                                           (string("SP=") + print_register(state.sp)).c_str());
+                                           (string("SP=") + print_register(regs.sp)).c_str());
                         ImGui::TextColored(ImVec4{1.0f, 0.0f, 0.0f, 1.0f}, "%s",
-                                           (string("I =") + print_register(state.I)).c_str());
+                                           (string("I =") + print_register(regs.I)).c_str());
                         ImGui::TextColored(ImVec4{0.5f, 0.5f, 1.0f, 1.0f}, "%s",
-                                           (string("DT=") + print_register(state.dt)).c_str());
+                                           (string("DT=") + print_register(regs.dt)).c_str());
                         ImGui::TextColored(ImVec4{0.5f, 0.5f, 1.0f, 1.0f}, "%s",
-                                           (string("ST=") + print_register(state.st)).c_str());
+                                           (string("ST=") + print_register(regs.st)).c_str());
                         ImGui::TextColored(ImVec4{1.0f, 1.0f, 0.0f, 1.0f}, "%s",
-                                           (string("K =") + print_register(state.lastKey)).c_str());
+                                           (string("K =") + print_register(regs.lastKey)).c_str());
                         ImGui::NextColumn();
                         for (int r = 0; r < V_REGISTERS_SIZE; r++) {
                             ImGui::Text("%s",
-                                        (string("V") + std::to_string(r) + "=" + print_register(state.v[r])).c_str());
+                                        (string("V") + std::to_string(r) + "=" + print_register(regs.v[r])).c_str());
                         }
 
                         ImGui::Separator();
@@ -503,138 +714,641 @@ namespace yac8 {
 
                         ImGui::Checkbox("Paused", &debug_state.paused);
                         ImGui::Checkbox("Freeze Timers", &debug_state.freezeTimers);
+                        if (ImGui::Checkbox("Profile", &profiling)) {
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            machine.setProfiler(profiling ? profiler.get() : nullptr);
+                        }
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Count executions per address, and show the hottest code");
+                        ImGui::SameLine();
+                        if (ImGui::Checkbox("Opcode Stats", &countingOpcodes)) {
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            if (countingOpcodes)
+                                opcodeStats->reset();
+                            machine.setOpcodeStats(countingOpcodes ? opcodeStats.get() : nullptr);
+                        }
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Count executions per instruction, and sample what each costs the host");
+                        uint64_t breakOnNext = 0;
                         if (ImGui::Button("Break on next (JP, CALL, RET)")) {
-                            debug_state.breakJP = true;
-                            debug_state.breakDRW = false;
-                            debug_state.breakLDK = false;
-                            debug_state.breakSKP = false;
-                            debug_state.paused = false;
+                            breakOnNext = opcodeBit(OP_RET) | opcodeBit(OP_JP) | opcodeBit(OP_CALL)
+                                    | opcodeBit(OP_SE_BYTE) | opcodeBit(OP_SNE_BYTE) | opcodeBit(OP_SE_REG)
+                                    | opcodeBit(OP_SNE_REG) | opcodeBit(OP_JP_V0);
                         }
                         if (ImGui::Button("Break on next Draw Call (DRW)")) {
-                            debug_state.breakJP = false;
-                            debug_state.breakDRW = true;
-                            debug_state.breakLDK = false;
-                            debug_state.breakSKP = false;
-                            debug_state.paused = false;
+                            breakOnNext = opcodeBit(OP_DRW);
                         }
                         if (ImGui::Button("Break on next Keypress Wait (LD Vx, K)")) {
-                            debug_state.breakJP = false;
-                            debug_state.breakDRW = false;
-                            debug_state.breakLDK = true;
-                            debug_state.breakSKP = false;
-                            debug_state.paused = false;
+                            breakOnNext = opcodeBit(OP_LD_VX_K);
                         }
                         if (ImGui::Button("Break on next Key Skip (SKP,SKNP)")) {
-                            debug_state.breakJP = false;
-                            debug_state.breakDRW = false;
-                            debug_state.breakLDK = false;
-                            debug_state.breakSKP = true;
+                            breakOnNext = opcodeBit(OP_SKP) | opcodeBit(OP_SKNP);
+                        }
+                        if (breakOnNext != 0) {
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            debug_state.breakpoints.breakOnNext(breakOnNext);
                             debug_state.paused = false;
                         }
                         if (ImGui::Button("Step")) {
                             debug_state.step = true;
                         }
+                        ImGui::SameLine();
+                        if (ImGui::Button("Step Back")) {
+                            stepBack = true;
+                        }
+                        ImGui::SameLine();
+                        if (ImGui::Button("Back to Breakpoint")) {
+                            backToBreakpoint = true;
+                        }
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Run backwards to the last time a breakpoint would have stopped execution");
                         if (ImGui::Button("Clear Breakpoints")) {
-                            std::fill(debug_state.breakPoints,
-                                      debug_state.breakPoints + sizeof(debug_state.breakPoints), false);
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            debug_state.breakpoints.clear();
+                        }
+                    }
+                    ImGui::End();
+
+                    if (ImGui::Begin("Breakpoints")) {
+                        // conditional breakpoints, e.g. "V3 == 0x10 && I > 0x300"
+                        bool addCondition = ImGui::InputText("##condition", conditionText, sizeof(conditionText),
+                                                             ImGuiInputTextFlags_EnterReturnsTrue);
+                        ImGui::SameLine();
+                        addCondition |= ImGui::Button("Add Condition");
+                        if (addCondition) {
+                            c8_condition condition;
+                            if (condition.compile(conditionText, conditionError)) {
+                                std::lock_guard<std::mutex> lock(state_mutex);
+                                debug_state.breakpoints.addCondition(condition);
+                                conditionText[0] = '\0';
+                                conditionError.clear();
+                            }
+                        }
+                        if (!conditionError.empty()) {
+                            ImGui::TextColored(ImVec4{1.0f, 0.0f, 0.0f, 1.0f}, "%s", conditionError.c_str());
+                        }
+
+                        // memory watchpoints
+                        ImGui::InputInt("Start##watch", &watchStart, 1, 16, ImGuiInputTextFlags_CharsHexadecimal);
+                        ImGui::InputInt("Length##watch", &watchLength);
+                        ImGui::Checkbox("Read", &watchRead);
+                        ImGui::SameLine();
+                        ImGui::Checkbox("Write", &watchWrite);
+                        ImGui::SameLine();
+                        if (ImGui::Button("Add Watchpoint") && (watchRead || watchWrite)) {
+                            c8_watchpoint watchpoint;
+                            watchpoint.start = (uint16_t) std::min(std::max(watchStart, 0), RAM_SIZE - 1);
+                            watchpoint.end = (uint16_t) std::min(watchpoint.start + std::max(watchLength, 1), RAM_SIZE);
+                            watchpoint.read = watchRead;
+                            watchpoint.write = watchWrite;
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            debug_state.breakpoints.addWatchpoint(watchpoint);
+                        }
+
+                        ImGui::Separator();
+                        std::lock_guard<std::mutex> lock(state_mutex);
+                        const std::vector<c8_condition> &conditions = debug_state.breakpoints.getConditions();
+                        for (size_t i = 0; i < conditions.size(); i++) {
+                            ImGui::PushID((int) i);
+                            if (ImGui::SmallButton("x")) {
+                                debug_state.breakpoints.removeCondition(i);
+                                ImGui::PopID();
+                                break;
+                            }
+                            ImGui::SameLine();
+                            ImGui::Text("if %s", conditions[i].source.c_str());
+                            ImGui::PopID();
+                        }
+                        const std::vector<c8_watchpoint> &watchpoints = debug_state.breakpoints.getWatchpoints();
+                        for (size_t i = 0; i < watchpoints.size(); i++) {
+                            ImGui::PushID((int) (i + conditions.size()));
+                            if (ImGui::SmallButton("x")) {
+                                debug_state.breakpoints.removeWatchpoint(i);
+                                ImGui::PopID();
+                                break;
+                            }
+                            ImGui::SameLine();
+                            ImGui::Text("%s%s 0x%03x-0x%03x", watchpoints[i].read ? "R" : "", watchpoints[i].write ? "W" : "",
+                                        watchpoints[i].start, watchpoints[i].end - 1);
+                            ImGui::PopID();
                         }
                     }
                     ImGui::End();
 
                     ImGui::Begin("Instruction View");
-                    for (int i = -10; i <= 11; ++i) {
-                        int instNum = state.pc + i * 2;
-                        if (instNum < PROGRAM_OFFSET || instNum >= RAM_SIZE) {
-                            ImGui::Text("???");
-                        } else {
-                            bool isPC = instNum == state.pc;
+                    // the profiler's counts, as a heat map next to each instruction
+                    uint64_t hottest = 1, totalExecutions = 1;
+                    state_mutex.lock();
+                    disassembly->refresh(state, quirks);
+                    if (profiling) {
+                        hottest = std::max<uint64_t>(1, profiler->hottest);
+                        totalExecutions = std::max<uint64_t>(1, profiler->totalExecutions);
+                    }
+                    state_mutex.unlock();
+                    int pc = regs.pc;
+                    disassembly->setEnd(std::max<int>(PROGRAM_OFFSET + (int) romData.size(), pc + 2));
+
+                    int scrollToLine = -1;
+                    if (followPC && pc != lastPC && pc >= PROGRAM_OFFSET && pc < RAM_SIZE) {
+                        scrollToLine = disassembly->lineOf(pc);
+                    }
+                    lastPC = pc;
+                    ImGui::SetNextItemWidth(60);
+                    if (ImGui::InputText("Go to", gotoText, sizeof(gotoText),
+                                         ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue)) {
+                        int address = (int) std::strtol(gotoText, nullptr, 16);
+                        if (address >= PROGRAM_OFFSET && address < RAM_SIZE) {
+                            disassembly->setEnd(std::max(address + 2, PROGRAM_OFFSET + (int) romData.size()));
+                            scrollToLine = disassembly->lineOf(address);
+                            followPC = false;
+                        }
+                    }
+                    ImGui::SameLine();
+                    ImGui::Checkbox("Follow PC", &followPC);
+
+                    // only the visible lines are drawn, so this costs the same for any size of ROM
+                    ImGui::BeginChild("listing");
+                    float lineHeight = ImGui::GetTextLineHeightWithSpacing();
+                    if (scrollToLine >= 0) {
+                        ImGui::SetScrollY(std::max(0.0f, scrollToLine * lineHeight - ImGui::GetWindowHeight() / 2));
+                    }
+                    ImGuiListClipper clipper;
+                    clipper.Begin(disassembly->lineCount(), lineHeight);
+                    std::vector<uint64_t> counts;
+                    while (clipper.Step()) {
+                        // the emulation thread keeps counting, so only the visible lines' counts are copied out
+                        if (profiling) {
+                            counts.resize(clipper.DisplayEnd - clipper.DisplayStart);
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; line++) {
+                                counts[line - clipper.DisplayStart] = profiler->executions[disassembly->addressOf(line)];
+                            }
+                        }
+                        for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; line++) {
+                            int instNum = disassembly->addressOf(line);
+                            bool isPC = instNum == pc || instNum + 1 == pc;
                             if (isPC) {
                                 ImGui::PushStyleColor(0, ImVec4{0.0f, 1.0f, 0.0f, 1.0f});
                             }
-                            string instruction = print_instruction(instNum, state, quirks);
-                            ImGui::Selectable(instruction.c_str(), &debug_state.breakPoints[instNum - PROGRAM_OFFSET]);
+                            if (profiling) {
+                                uint64_t count = counts[line - clipper.DisplayStart];
+                                float heat = count == 0 ? 0.0f : (float) (std::log1p((double) count) / std::log1p((double) hottest));
+                                ImGui::TextColored(ImVec4{0.3f + 0.7f * heat, 0.3f, 1.0f - 0.7f * heat, 1.0f}, "%5.1f%%",
+                                                   100.0 * count / totalExecutions);
+                                ImGui::SameLine();
+                            }
+                            char label[16];
+                            if (!disassembly->label(line, label, sizeof(label))) {
+                                label[0] = '\0';
+                            }
+                            ImGui::TextColored(ImVec4{1.0f, 1.0f, 0.0f, 1.0f}, "%-9s", label);
+                            ImGui::SameLine();
+                            ImGui::PushID(line);
+                            if (ImGui::Selectable(disassembly->text(line), debug_state.breakpoints.hasAddress(instNum))) {
+                                std::lock_guard<std::mutex> lock(state_mutex);
+                                debug_state.breakpoints.toggleAddress(instNum);
+                            }
+                            // the live operand values, for the one line under the mouse
+                            if (ImGui::IsItemHovered()) {
+                                std::lock_guard<std::mutex> lock(state_mutex);
+                                ImGui::SetTooltip("%s", print_instruction(instNum, state, quirks).c_str());
+                            }
+                            ImGui::PopID();
                             if (isPC) {
                                 ImGui::PopStyleColor();
                             }
                         }
                     }
+                    ImGui::EndChild();
                     ImGui::End();
+
+                    if (profiling) {
+                        ImGui::Begin("Hot Blocks");
+                        if (ImGui::Button("Reset Counts")) {
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            profiler->reset();
+                        }
+                        ImGui::SameLine();
+                        if (ImGui::Button("Export CSV")) {
+                            string csvFilename = "yac8-profile-" + std::to_string(std::time(nullptr)) + ".csv";
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            if (!profiler->writeCSV(csvFilename)) {
+                                std::cerr << "Could not write " << csvFilename << std::endl;
+                            }
+                        }
+                        state_mutex.lock();
+                        std::vector<c8_profiler::block> blocks = profiler->hotBlocks(20);
+                        uint64_t total = std::max<uint64_t>(1, profiler->totalExecutions);
+                        state_mutex.unlock();
+
+                        ImGui::Columns(3);
+                        ImGui::Text("Block");
+                        ImGui::NextColumn();
+                        ImGui::Text("Executions");
+                        ImGui::NextColumn();
+                        ImGui::Text("Share");
+                        ImGui::NextColumn();
+                        ImGui::Separator();
+                        for (const c8_profiler::block &block : blocks) {
+                            ImGui::Text("0x%03x-0x%03x", block.start, block.end);
+                            ImGui::NextColumn();
+                            ImGui::Text("%llu", (unsigned long long) block.executions);
+                            ImGui::NextColumn();
+                            ImGui::Text("%.1f%%", 100.0 * block.executions / total);
+                            ImGui::NextColumn();
+                        }
+                        ImGui::Columns(1);
+                        ImGui::End();
+
+                        ImGui::Begin("Call Tree");
+                        if (ImGui::Button("Export Flame Graph")) {
+                            string stacksFilename = "yac8-stacks-" + std::to_string(std::time(nullptr)) + ".txt";
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            if (!profiler->writeCollapsedStacks(stacksFilename)) {
+                                std::cerr << "Could not write " << stacksFilename << std::endl;
+                            }
+                        }
+                        if (ImGui::IsItemHovered())
+                            ImGui::SetTooltip("Write collapsed stacks, for flamegraph.pl or speedscope");
+
+                        state_mutex.lock();
+                        std::vector<c8_profiler::call_node> callTree = profiler->callTree;
+                        state_mutex.unlock();
+                        std::vector<uint64_t> inclusive(callTree.size());
+                        std::vector<std::vector<int32_t>> children(callTree.size());
+                        for (size_t i = callTree.size(); i-- > 0;) {
+                            inclusive[i] += callTree[i].exclusive;
+                            if (callTree[i].parent >= 0) {
+                                inclusive[callTree[i].parent] += inclusive[i];
+                                children[callTree[i].parent].push_back((int32_t) i);
+                            }
+                        }
+                        uint64_t treeTotal = std::max<uint64_t>(1, inclusive[0]);
+
+                        ImGui::Columns(4);
+                        ImGui::Text("Routine");
+                        ImGui::NextColumn();
+                        ImGui::Text("Inclusive");
+                        ImGui::NextColumn();
+                        ImGui::Text("Exclusive");
+                        ImGui::NextColumn();
+                        ImGui::Text("Calls");
+                        ImGui::NextColumn();
+                        ImGui::Separator();
+                        // children were collected last to first, so sort them by cost instead
+                        std::function<void(int32_t)> drawNode = [&](int32_t node) {
+                            std::vector<int32_t> &kids = children[node];
+                            std::sort(kids.begin(), kids.end(), [&](int32_t a, int32_t b) { return inclusive[a] > inclusive[b]; });
+                            char name[16];
+                            if (node == 0) {
+                                std::snprintf(name, sizeof(name), "root");
+                            } else {
+                                std::snprintf(name, sizeof(name), "sub_%03x", callTree[node].routine);
+                            }
+                            ImGui::PushID(node);
+                            bool open = ImGui::TreeNodeEx(name, (kids.empty() ? ImGuiTreeNodeFlags_Leaf : 0) | (node == 0 ? ImGuiTreeNodeFlags_DefaultOpen : 0));
+                            ImGui::NextColumn();
+                            ImGui::Text("%.1f%%", 100.0 * inclusive[node] / treeTotal);
+                            ImGui::NextColumn();
+                            ImGui::Text("%.1f%%", 100.0 * callTree[node].exclusive / treeTotal);
+                            ImGui::NextColumn();
+                            ImGui::Text("%llu", (unsigned long long) callTree[node].calls);
+                            ImGui::NextColumn();
+                            if (open) {
+                                for (int32_t child : kids) {
+                                    drawNode(child);
+                                }
+                                ImGui::TreePop();
+                            }
+                            ImGui::PopID();
+                        };
+                        drawNode(0);
+                        ImGui::Columns(1);
+                        ImGui::End();
+                    }
+
+                    if (showMemory) {
+                        ImGui::Begin("Memory", &showMemory);
+                        ImGui::SetNextItemWidth(120);
+                        ImGui::SliderInt("Highlight writes (frames)", &memoryHighlightFrames, 1, 600);
+
+                        state_mutex.lock();
+                        uint32_t generation = writeTracker->update(state);
+                        state_mutex.unlock();
+                        uint16_t I = regs.I;
+                        uint8_t sp = regs.sp;
+                        const uint16_t *stack = regs.stack;
+                        c8_memory_access access = memoryAccessOf(snapshot.opcode, I, regs.planes);
+
+                        // the stack lives outside RAM, but the addresses it returns to are marked below
+                        ImGui::TextColored(ImVec4{0.5f, 1.0f, 0.5f, 1.0f}, "I=0x%03x", I);
+                        ImGui::SameLine();
+                        ImGui::TextColored(ImVec4{0.5f, 0.5f, 1.0f, 1.0f}, "stack:");
+                        for (int i = sp - 1; i >= 0; i--) {
+                            ImGui::SameLine();
+                            ImGui::Text("%03x", stack[i]);
+                        }
+                        ImGui::Separator();
+
+                        const uint32_t BYTES_PER_ROW = 16;
+                        ImGui::BeginChild("bytes");
+                        ImGuiListClipper clipper;
+                        clipper.Begin(RAM_SIZE / BYTES_PER_ROW);
+                        while (clipper.Step()) {
+                            // only the visible rows are copied, and only they hold the lock
+                            uint32_t first = clipper.DisplayStart * BYTES_PER_ROW, last = clipper.DisplayEnd * BYTES_PER_ROW;
+                            std::vector<uint8_t> bytes(last - first);
+                            state_mutex.lock();
+                            std::copy(state.ram + first, state.ram + last, bytes.begin());
+                            state_mutex.unlock();
+
+                            for (uint32_t start = first; start < last; start += BYTES_PER_ROW) {
+                                ImGui::Text("%04x:", start);
+                                char ascii[BYTES_PER_ROW + 1];
+                                for (uint32_t i = 0; i < BYTES_PER_ROW; i++) {
+                                    uint32_t addr = start + i;
+                                    uint8_t byte = bytes[addr - first];
+                                    ImVec4 color{0.7f, 0.7f, 0.7f, 1.0f};
+                                    if ((access.readStart <= addr && addr < access.readEnd)
+                                        || (access.writeStart <= addr && addr < access.writeEnd)) {
+                                        color = ImVec4{0.5f, 1.0f, 0.5f, 1.0f};
+                                    } else if (addr == I) {
+                                        color = ImVec4{0.0f, 1.0f, 0.0f, 1.0f};
+                                    }
+                                    for (int s = 0; s < sp; s++) {
+                                        if (addr == stack[s] || addr == stack[s] + 1u)
+                                            color = ImVec4{0.5f, 0.5f, 1.0f, 1.0f};
+                                    }
+                                    uint32_t writtenIn = writeTracker->writtenIn((uint16_t) addr);
+                                    uint32_t age = generation - writtenIn;
+                                    if (writtenIn != 0 && age < (uint32_t) memoryHighlightFrames) {
+                                        float fade = 1.0f - (float) age / memoryHighlightFrames;
+                                        color = ImVec4{0.6f + 0.4f * fade, 0.6f - 0.4f * fade, 0.6f - 0.4f * fade, 1.0f};
+                                    }
+                                    ImGui::SameLine();
+                                    ImGui::TextColored(color, "%02x", byte);
+                                    ascii[i] = byte >= 0x20 && byte < 0x7F ? (char) byte : '.';
+                                }
+                                ascii[BYTES_PER_ROW] = '\0';
+                                ImGui::SameLine();
+                                ImGui::TextDisabled("%s", ascii);
+                            }
+                        }
+                        ImGui::EndChild();
+                        ImGui::End();
+                    }
+
+                    if (countingOpcodes) {
+                        ImGui::Begin("Opcode Stats");
+                        if (ImGui::Button("Reset Counts")) {
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            opcodeStats->reset();
+                        }
+                        ImGui::SameLine();
+                        if (ImGui::Button("Export CSV")) {
+                            string csvFilename = "yac8-opstats-" + std::to_string(std::time(nullptr)) + ".csv";
+                            std::lock_guard<std::mutex> lock(state_mutex);
+                            if (!opcodeStats->writeCSV(csvFilename)) {
+                                std::cerr << "Could not write " << csvFilename << std::endl;
+                            }
+                        }
+
+                        // copy what's drawn so the emulation thread isn't held up by the ui
+                        state_mutex.lock();
+                        uint64_t counts[OP_COUNT];
+                        uint64_t histogram[OP_COUNT][COST_HISTOGRAM_BUCKETS];
+                        double meanNanos[OP_COUNT];
+                        std::copy(opcodeStats->counts, opcodeStats->counts + OP_COUNT, counts);
+                        std::copy(&opcodeStats->histogram[0][0], &opcodeStats->histogram[0][0] + OP_COUNT * COST_HISTOGRAM_BUCKETS,
+                                  &histogram[0][0]);
+                        for (int op = 0; op < OP_COUNT; op++) {
+                            meanNanos[op] = opcodeStats->meanNanos(static_cast<c8_opcode_class>(op));
+                        }
+                        state_mutex.unlock();
+                        uint64_t total = std::max<uint64_t>(1, std::accumulate(counts, counts + OP_COUNT, uint64_t(0)));
+
+                        ImGui::Columns(4);
+                        ImGui::Text("Opcode");
+                        ImGui::NextColumn();
+                        ImGui::Text("Executions");
+                        ImGui::NextColumn();
+                        ImGui::Text("Share");
+                        ImGui::NextColumn();
+                        ImGui::Text("Host ns");
+                        ImGui::NextColumn();
+                        ImGui::Separator();
+                        for (int op = 0; op < OP_COUNT; op++) {
+                            if (counts[op] == 0)
+                                continue;
+                            ImGui::Text("%s", OPCODE_NAMES[op]);
+                            ImGui::NextColumn();
+                            ImGui::Text("%llu", (unsigned long long) counts[op]);
+                            ImGui::NextColumn();
+                            ImGui::Text("%.1f%%", 100.0 * counts[op] / total);
+                            ImGui::NextColumn();
+                            ImGui::Text("%.1f", meanNanos[op]);
+                            // the cost distribution, in powers of two of timer ticks
+                            if (ImGui::IsItemHovered()) {
+                                float buckets[COST_HISTOGRAM_BUCKETS];
+                                for (int b = 0; b < COST_HISTOGRAM_BUCKETS; b++) {
+                                    buckets[b] = (float) histogram[op][b];
+                                }
+                                ImGui::BeginTooltip();
+                                ImGui::PlotHistogram("##cost", buckets, COST_HISTOGRAM_BUCKETS, 0, "ticks, log2",
+                                                     0.0f, FLT_MAX, ImVec2(240, 80));
+                                ImGui::EndTooltip();
+                            }
+                            ImGui::NextColumn();
+                        }
+                        ImGui::Columns(1);
+                        ImGui::End();
+                    }
                 }
             }
 
             // rendering
             {
+                auto upload_start = std::chrono::steady_clock::now();
+                frame.imgui = std::chrono::duration<double>(upload_start - imgui_start).count();
                 glClearColor(1.0f,0.0f,1.0f,1.0f);
                 glClear(GL_COLOR_BUFFER_BIT);
 
                 glBindTexture(GL_TEXTURE_2D, screenBufferTex);
 
                 // simulate phosphorescent display
-                for(int i = 0; i < sizeof(decayingPixelBuffer); i++) {
-                    if(pixels[i]) decayingPixelBuffer[i] = 255;
-                    else {
-                        decayingPixelBuffer[i] *= screenDecayFactor;
-                    }
+                {
+                    YAC8_TRACE_SCOPE("phosphor decay");
+                    decayPhosphor(machine.display, decayingPixelBuffer, screenDecayFactor);
                 }
 
                 // expensive operation: copying pixel buffer from cpu to gpu
-                glTexSubImage2D(
-                        GL_TEXTURE_2D, 0, 0, 0,
-                        WINDOW_WIDTH, WINDOW_HEIGHT,
-                        GL_RED, GL_UNSIGNED_BYTE, decayingPixelBuffer);
-
-                glBindTexture(GL_TEXTURE_2D, screenBufferTex);
-                glActiveTexture(GL_TEXTURE0);
-
-                glUniform4f(glGetUniformLocation(crtShaderProgram, "background"),bgColor[0],bgColor[1],bgColor[2],1.0f);
-                glUniform4f(glGetUniformLocation(crtShaderProgram, "foreground"),fgColor[0],fgColor[1],fgColor[2],1.0f);
-                glUniform1f(glGetUniformLocation(crtShaderProgram, "CRT_CURVE_AMNTx"),screenCurveX);
-                glUniform1f(glGetUniformLocation(crtShaderProgram, "CRT_CURVE_AMNTy"),screenCurveY);
-                glUniform1f(glGetUniformLocation(crtShaderProgram, "SCAN_LINE_MULT"),(float)scanLineMult);
-                glUniform1f(glGetUniformLocation(crtShaderProgram, "e"), softness / 10000.0f);
+                {
+                    YAC8_TRACE_SCOPE("upload texture");
+                    glTexSubImage2D(
+                            GL_TEXTURE_2D, 0, 0, 0,
+                            HIRES_WIDTH, HIRES_HEIGHT,
+                            GL_RG, GL_UNSIGNED_BYTE, decayingPixelBuffer);
+                }
+                auto crt_start = std::chrono::steady_clock::now();
+                frame.upload = std::chrono::duration<double>(crt_start - upload_start).count();
+
+                {
+                    YAC8_TRACE_SCOPE("crt draw");
+                    glBindTexture(GL_TEXTURE_2D, screenBufferTex);
+                    glActiveTexture(GL_TEXTURE0);
+
+                    glUniform4f(glGetUniformLocation(crtShaderProgram, "background"),bgColor[0],bgColor[1],bgColor[2],1.0f);
+                    glUniform4f(glGetUniformLocation(crtShaderProgram, "foreground"),fgColor[0],fgColor[1],fgColor[2],1.0f);
+                    glUniform4f(glGetUniformLocation(crtShaderProgram, "foreground2"),plane2Color[0],plane2Color[1],plane2Color[2],1.0f);
+                    glUniform4f(glGetUniformLocation(crtShaderProgram, "foreground3"),bothPlanesColor[0],bothPlanesColor[1],bothPlanesColor[2],1.0f);
+                    glUniform1f(glGetUniformLocation(crtShaderProgram, "CRT_CURVE_AMNTx"),screenCurveX);
+                    glUniform1f(glGetUniformLocation(crtShaderProgram, "CRT_CURVE_AMNTy"),screenCurveY);
+                    glUniform1f(glGetUniformLocation(crtShaderProgram, "SCAN_LINE_MULT"),(float)scanLineMult);
+                    glUniform1f(glGetUniformLocation(crtShaderProgram, "e"), softness / 10000.0f);
+
+                    glViewport(0,0,WINDOW_WIDTH*scale,WINDOW_HEIGHT*scale);
+
+                    glUseProgram(crtShaderProgram);
+                    glDrawArrays(GL_TRIANGLES, 0, 3);
+                }
+                auto imgui_render_start = std::chrono::steady_clock::now();
+                frame.crt = std::chrono::duration<double>(imgui_render_start - crt_start).count();
 
-                glViewport(0,0,WINDOW_WIDTH*scale,WINDOW_HEIGHT*scale);
+                {
+                    YAC8_TRACE_SCOPE("imgui draw");
+                    ImGui::Render();
+                    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                }
+                auto swap_start = std::chrono::steady_clock::now();
+                frame.imgui += std::chrono::duration<double>(swap_start - imgui_render_start).count();
+                {
+                    YAC8_TRACE_SCOPE("swap");
+                    SDL_GL_SwapWindow(window);
+                }
+                auto swap_end = std::chrono::steady_clock::now();
+                frame.swap = std::chrono::duration<double>(swap_end - swap_start).count();
+                // the whole frame, including event handling and the rest of the loop since the previous swap
+                frame.total = std::chrono::duration<double>(swap_end - frame_end).count();
+                frame_end = swap_end;
+                metrics.recordFrame(frame);
+                metrics.update(processorSpeed, noisemaker.queuedMillis());
+                SDL_Delay(1000/120);
+            }
 
-                glUseProgram(crtShaderProgram);
-                glDrawArrays(GL_TRIANGLES, 0, 3);
+            if(!romToOpen.empty() && !pendingRom.valid()) {
+                pendingRom = library.load(romToOpen);
+                romToOpen.clear();
+            }
+            // pick up an opened ROM once it has been read from disk
+            if(pendingRom.valid() && pendingRom.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                romToLoad = pendingRom.get();
+                loadRom = romToLoad.data != nullptr;
+                if(!loadRom) {
+                    std::cerr << "Could not load ROM " << romToLoad.path << std::endl;
+                }
+            }
 
-                ImGui::Render();
-                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-                SDL_GL_SwapWindow(window);
-                SDL_Delay(1000/120);
+            // apply detected quirks, and cache them in the library so detection only ever runs once per ROM
+            if(pendingQuirks.valid() && pendingQuirks.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                c8_quirks detected = pendingQuirks.get();
+                if(pendingQuirksHash == currentRom.hash && !loadRom) {
+                    c8_rom_profile profile{};
+                    profile.quirks = detected;
+                    profile.processorSpeed = processorSpeed;
+                    library.setProfile(currentRom, profile);
+                    currentRom.hasProfile = true;
+                    currentRom.profile = profile;
+                    if(packQuirks(detected) != packQuirks(quirks)) {
+                        quirks = detected;
+                        reset = true;
+                    }
+                }
             }
 
             if(loadRom) {
-                std::ifstream is(romFilename, std::ios::in|std::ios::binary|std::ios::ate);
-                if(is.is_open()) {
-                    int size = is.tellg();
-                    romData.resize(size);
-                    is.seekg(0, std::ios::beg);
-                    is.read(&romData[0], size);
-                    is.close();
+                currentRom = romToLoad;
+                romData = *currentRom.data;
+
+                // apply the settings this ROM is known to need, or work them out in the background
+                if(currentRom.hasProfile) {
+                    quirks = currentRom.profile.quirks;
+                    processorSpeed = currentRom.profile.processorSpeed;
+                }
+                detectQuirksWanted = !currentRom.hasProfile;
+
+                // remove breakpoints
+                state_mutex.lock();
+                debug_state.breakpoints.clear();
+                state_mutex.unlock();
+
+                // remove incompatibility flag
+                incompatible_flag = false;
 
-                    // remove breakpoints
-                    std::fill(debug_state.breakPoints, debug_state.breakPoints+sizeof(debug_state.breakPoints), false);
+                reset = true;
+            }
 
-                    // remove incompatibility flag
-                    incompatible_flag = false;
+            // a detection for a ROM that has since been replaced still runs to the end, and its result is dropped
+            if(detectQuirksWanted && !pendingQuirks.valid()) {
+                detectQuirksWanted = false;
+                pendingQuirksHash = currentRom.hash;
+                std::vector<char> rom = romData;
+                int speed = processorSpeed;
+                pendingQuirks = std::async(std::launch::async, [rom, speed]() {
+                    return detectQuirks((const uint8_t *) rom.data(), (int) rom.size(), speed);
+                });
+            }
 
-                    reset = true;
+            // go back in time by restoring a snapshot and re-running from it. The movie being recorded can't follow
+            if(stepBack || backToBreakpoint) {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                recorder.stop(machine.cycle);
+                bool rewound = stepBack ? rewind.seek(machine, machine.cycle - 1)
+                                        : rewind.seekBreakpoint(machine, debug_state.breakpoints);
+                if(rewound) {
+                    // the conditions' edges continue from where the machine is now
+                    debug_state.breakpoints.prime(machine.state);
+                    debug_state.paused = true;
+                    processorSpeed = machine.processorSpeed;
+                    quirks = machine.quirks;
                 }
             }
 
             if(reset) {
                 state_mutex.lock();
-                state = {};
-                clearScreen();
-                state.loadROM((const uint8_t *) romData.data(), romData.size());
-                state.loadTypography(yac8::default_typography_buffer);
+                // a movie can't survive a reset, since the new run gets a new seed
+                recorder.stop(machine.cycle);
+                uint32_t seed = seeder();
+                machine.quirks = quirks;
+                machine.processorSpeed = processorSpeed;
+                machine.reset((const uint8_t *) romData.data(), romData.size(), seed);
+                rewind.clear();
+
+                // key events queued for the previous run no longer apply
+                c8_movie_event stale;
+                while(input.pop(stale)) {}
+
+                if(startRecording) {
+                    c8_movie header{};
+                    header.seed = seed;
+                    header.quirks = quirks;
+                    header.processorSpeed = processorSpeed;
+                    header.romHash = currentRom.hash;
+                    string movieFilename = "yac8-" + std::to_string(std::time(nullptr)) + ".c8m";
+                    if(!recorder.start(movieFilename, header)) {
+                        std::cerr << "Could not open " << movieFilename << " for recording" << std::endl;
+                    }
+                }
                 state_mutex.unlock();
             }
         }
 
         // wait for emu thread to get the memo
         emuThread.join();
+        recorder.stop(machine.cycle);
+        machine.setTracer(nullptr);
+        machine.setProfiler(nullptr);
+        machine.setOpcodeStats(nullptr);
+        tracer.stop();
 
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplSDL2_Shutdown();
@@ -642,38 +1356,4 @@ namespace yac8 {
 
         SDL_DestroyWindow(window);
     }
-
-    void c8_emulator::clearScreen() {
-        std::fill(pixels, pixels + WINDOW_WIDTH * WINDOW_HEIGHT, false);
-    }
-
-    void c8_emulator::drawSprite(const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t &VF) {
-        VF = 0;
-        x = x % WINDOW_WIDTH;
-        y = y % WINDOW_HEIGHT;
-
-        for(int j = 0; j < n; j++) {
-            for(int i = 1; i <= 8; i++) {
-                uint8_t value = (sprite[j] >> (8-i)) & 0b1;
-                if(value > 0) {
-                    int px = x+i - 1;
-                    int py = y+j;
-
-                    if(quirks.wrap) {
-                        px = px % WINDOW_WIDTH;
-                        py = py % WINDOW_HEIGHT;
-                    } else {
-                        if(px > WINDOW_WIDTH || py > WINDOW_HEIGHT)
-                            continue;
-                    }
-
-                    bool &bufferPix = pixels[py*WINDOW_WIDTH+px];
-                    uint8_t previous = bufferPix;
-                    bufferPix ^= value;
-                    if(bufferPix == 0 && previous != 0)
-                        VF = 1;
-                }
-            }
-        }
-    }
 }
\ No newline at end of file
@@ -6,34 +6,23 @@
 #include <unordered_map>
 #include <glad/glad.h>
 
+#include "c8_breakpoints.hpp"
 #include "c8_constants.hpp"
-#include "c8_state.hpp"
+#include "c8_demo_rom.hpp"
+#include "c8_machine.hpp"
+#include "c8_metrics.hpp"
+#include "c8_movie.hpp"
+#include "c8_noisemaker.hpp"
+#include "c8_rewind.hpp"
+#include "c8_ring_buffer.hpp"
+#include "c8_seqlock.hpp"
 
 namespace yac8 {
     // accounts for the size of the menu bar
     const int VIEWPORT_Y_OFFSET = 19;
-    const int MAX_SPEED = 4000;
-
-    // egomaniacal bootup sequence
-    const uint16_t DEMO_ROM[] = {
-            0x0b12,0x7962,0x5720,0x5345,0x4c20,
-            0x602e,0x6105,0x6216,0xa21e,0xd150,
-            0xa20f,0xd25f,0x630f,0xa210,0xd36e,
-            0x7315,0xa206,0xd373,0x7315,0xa206,
-            0xd378,0x7315,0xa206,0xd37d,0x7315,
-            0xa206,0xd382,0x6015,0x6100,0x6200,
-            0x633f,0xa21f,0xd04f,0x7011,0xd202,
-            0x7231,0x12fe,0x2841,0x4482,0x8038,
-            0x6300,0x3e77,0x1c1c,0x001c,0x7f3e,
-            0x6063,0x7f63,0x003e,0x773e,0x7f63,
-            0x6363,0x3e00,0x6363,0x633e,0x3e63,
-            0x88f0,0x88f0,0x88f0,0x2050,0x2020,
-            0x8888,0xa888,0xf8d8,0xf080,0xf880,
-            0x8078,0x0870,0x00f0,
-    };
 
     /**
-     * A POD struct of state for the debugger.
+     * A struct of state for the debugger.
      */
     struct c8_debugger_state {
         bool enabled = false;
@@ -41,11 +30,18 @@ namespace yac8 {
         bool step = false;
         bool freezeTimers = false;
 
-        bool breakJP = false;
-        bool breakDRW = false;
-        bool breakLDK = false;
-        bool breakSKP = false;
-        bool breakPoints[RAM_SIZE-PROGRAM_OFFSET] = {false};
+        // read by the emulation thread, so only modify it with the state mutex held
+        c8_breakpoints breakpoints{};
+    };
+
+    /**
+     * What the UI shows of the machine between emulation slices.
+     */
+    struct c8_register_snapshot {
+        c8_registers registers;
+        uint64_t cycle = 0;
+        // the instruction at PC, about to execute
+        uint16_t opcode = 0;
     };
 
     /**
@@ -56,22 +52,37 @@ namespace yac8 {
 
         float bgColor[4] = {15.0f/255.0f, 35.0f/255.0f, 17.0f/255.0f};
         float fgColor[4] = {141.0f/255.0f, 255.0f/255.0f, 128.0f/255.0f};
+        float plane2Color[4] = {255.0f/255.0f, 170.0f/255.0f, 60.0f/255.0f};
+        float bothPlanesColor[4] = {240.0f/255.0f, 255.0f/255.0f, 230.0f/255.0f};
         float screenCurveX = 0.25f, screenCurveY = 0.25f;
         int scanLineMult = 1250;
         float softness = 4.0f;
         float screenDecayFactor = 0.7f;
 
-        void clearScreen();
-        void drawSprite(const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t &VF);
-
     public:
-        bool pixels[WINDOW_WIDTH * WINDOW_HEIGHT] = {0};
-        uint8_t decayingPixelBuffer[WINDOW_WIDTH * WINDOW_HEIGHT] = {0};
+        uint8_t decayingPixelBuffer[HIRES_WIDTH * HIRES_HEIGHT * c8_display::PLANES] = {0};
         int processorSpeed = 1000;
         bool slowedProcessorSpeed = true;
+        // run guest time at the rate the audio device plays it, keeping audioLatencyMs of sound ahead of it
+        bool audioPacing = false;
+        int audioLatencyMs = 40;
         c8_quirks quirks{};
         c8_debugger_state debug_state{};
 
+        // owned by the emulation thread while it runs; only touch it with the state mutex held
+        c8_machine machine{};
+        // key events from the UI thread, applied by the emulation thread at the current guest cycle
+        c8_ring_buffer<c8_movie_event, 256> input{};
+        c8_movie_recorder recorder{};
+        c8_tracer tracer{};
+        // snapshots and input history, for stepping backwards in the debugger
+        c8_rewind rewind{};
+        c8_metrics metrics{};
+        // the registers as of the end of the last emulation slice, for the UI to read without taking the state lock
+        c8_seqlock<c8_register_snapshot> registers{};
+        // sound timer edges and guest time, for the buzzer on the audio thread
+        c8_sound_channel sound{};
+
         void run();
     };
 }
\ No newline at end of file
@@ -7,8 +7,12 @@ namespace yac8 {
      * A set of functions that define every hardware operation a Chip-8 instruction could kick off.
      */
     struct c8_hardware_api {
-        std::function<void(const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t &VF)> draw_sprite;
-        std::function<void()> clear_screen;
+        // `planes` is the XO-CHIP bitplane mask the operation applies to, see c8_display
+        std::function<void(const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t planes, uint8_t &VF)> draw_sprite;
+        std::function<void(uint8_t planes)> clear_screen;
+        // SUPER-CHIP: moves the screen contents by (dx, dy) pixels, and switches between 64x32 and 128x64
+        std::function<void(int dx, int dy, uint8_t planes)> scroll_screen;
+        std::function<void(bool hires)> set_resolution;
         std::function<uint8_t()> random_byte;
     };
 }
\ No newline at end of file
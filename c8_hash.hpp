@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace yac8 {
+    const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    /**
+     * 64-bit FNV-1a. Pass a previous result as `hash` to hash several buffers as one.
+     */
+    inline uint64_t fnv1a(const void *data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for(size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <random>
+
+#include "c8_machine.hpp"
+
+namespace yac8 {
+    /**
+     * Key presses that only depend on a seed: a random key, or none, is held for 0-19 frames at a time.
+     * Headless runs use it so that a ROM sees exactly the same input every time.
+     */
+    class c8_input_script {
+        std::mt19937 rng;
+        int heldKey = -1;
+        int holdFrames = 0;
+    public:
+        explicit c8_input_script(uint32_t seed) : rng(seed) {}
+
+        // call at the start of every guest frame. `Target` is a c8_machine, or anything else with press()/release()
+        template<class Target>
+        void frame(Target &machine) {
+            if(holdFrames-- > 0)
+                return;
+            if(heldKey >= 0)
+                machine.release(static_cast<uint8_t>(heldKey));
+            heldKey = static_cast<int>(rng() % 17) - 1; // -1 means no key
+            holdFrames = static_cast<int>(rng() % 20);
+            if(heldKey >= 0)
+                machine.press(static_cast<uint8_t>(heldKey));
+        }
+    };
+}
@@ -0,0 +1,164 @@
+#include "c8_machine.hpp"
+#include "c8_hash.hpp"
+#include "c8_opcodes.hpp"
+
+#include <cstring>
+
+namespace yac8 {
+    c8_machine::c8_machine() {
+        hardware_api.draw_sprite = [this](const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t planes, uint8_t &VF) {
+            display.drawSprite(sprite, x, y, n, planes, VF, quirks.wrap);
+        };
+        hardware_api.clear_screen = [this](uint8_t planes) { display.clear(planes); };
+        hardware_api.scroll_screen = [this](int dx, int dy, uint8_t planes) { display.scroll(dx, dy, planes); };
+        hardware_api.set_resolution = [this](bool hires) { display.setHires(hires); };
+        hardware_api.random_byte = [this]()->uint8_t { return (uint8_t)(rng() >> 24); };
+    }
+
+    void c8_machine::reset(const uint8_t *rom, int size, uint32_t seed) {
+        // watchers tell a reset apart from the previous run by the reload count, so it keeps counting
+        uint32_t reloads = state.reloads;
+        state = {};
+        state.reloads = reloads;
+        display.setHires(false);
+        state.loadROM(rom, size);
+        state.loadTypography(yac8::default_typography_buffer);
+        rng.seed(seed);
+        cycle = 0;
+        timerPhase = 0;
+    }
+
+    bool c8_machine::step() {
+        if(instrumented)
+            return instrumentedStep();
+        return advance();
+    }
+
+    bool c8_machine::advance() {
+        bool valid = state.step(hardware_api, quirks);
+        cycle++;
+        if(!freezeTimers) {
+            timerPhase += TIMER_FREQUENCY;
+            if(timerPhase >= processorSpeed) {
+                timerPhase -= processorSpeed;
+                tickTimers();
+            }
+        }
+        return valid;
+    }
+
+    bool c8_machine::instrumentedStep() {
+        uint16_t pc = state.pc;
+        uint16_t opcode = pc <= RAM_SIZE - 2 ? (uint16_t)(state.ram[pc] << 8 | state.ram[pc + 1]) : 0;
+        uint64_t executedCycle = cycle;
+        // XO-CHIP's F000 takes its address from the next word, which the trace needs to show it
+        uint16_t longAddress = opcode == 0xF000 && pc <= RAM_SIZE - 4
+                               ? (uint16_t)(state.ram[pc + 2] << 8 | state.ram[pc + 3]) : 0;
+
+        bool sampled = opcodeStats != nullptr && opcodeStats->sampleNext();
+        uint64_t start = sampled ? c8_opcode_stats::ticks() : 0;
+        bool valid = advance();
+        if(sampled)
+            opcodeStats->sample(classifyOpcode(opcode), c8_opcode_stats::ticks() - start);
+        if(opcodeStats != nullptr)
+            opcodeStats->count(classifyOpcode(opcode));
+
+        if(profiler != nullptr && pc < RAM_SIZE)
+            profiler->record(pc, opcode, state.pc);
+
+        if(tracer != nullptr)
+            tracer->record(executedCycle, pc, opcode, longAddress, state);
+        return valid;
+    }
+
+    void c8_machine::setTracer(c8_tracer *t) {
+        tracer = t;
+        updateInstrumented();
+    }
+
+    void c8_machine::setProfiler(c8_profiler *p) {
+        profiler = p;
+        updateInstrumented();
+    }
+
+    void c8_machine::setOpcodeStats(c8_opcode_stats *s) {
+        opcodeStats = s;
+        updateInstrumented();
+    }
+
+    void c8_machine::updateInstrumented() {
+        instrumented = tracer != nullptr || profiler != nullptr || opcodeStats != nullptr;
+    }
+
+    void c8_machine::tickTimers() {
+        if(state.dt != 0)
+            state.dt -= 1;
+        if(state.st != 0)
+            state.st -= 1;
+        // a key press is only visible to LD Vx, K until the end of the frame it happened in
+        state.lastKey = NO_LAST_KEY;
+    }
+
+    void c8_machine::save(c8_machine_snapshot &snapshot) const {
+        snapshot.state = c8_paged_state(state);
+        snapshot.display = display;
+        snapshot.rng = rng;
+        snapshot.timerPhase = timerPhase;
+        snapshot.cycle = cycle;
+        snapshot.processorSpeed = processorSpeed;
+        snapshot.quirks = quirks;
+        snapshot.freezeTimers = freezeTimers;
+    }
+
+    void c8_machine::restore(const c8_machine_snapshot &snapshot) {
+        snapshot.state.store(state);
+        restoreMachine(snapshot);
+    }
+
+    void c8_machine::restoreWritten(const c8_machine_snapshot &snapshot, uint32_t pageWritesThen[PAGE_COUNT]) {
+        snapshot.state.storeWritten(state, pageWritesThen);
+        restoreMachine(snapshot);
+    }
+
+    void c8_machine::restoreMachine(const c8_machine_snapshot &snapshot) {
+        display = snapshot.display;
+        rng = snapshot.rng;
+        timerPhase = snapshot.timerPhase;
+        cycle = snapshot.cycle;
+        processorSpeed = snapshot.processorSpeed;
+        quirks = snapshot.quirks;
+        freezeTimers = snapshot.freezeTimers;
+    }
+
+    void c8_machine::press(uint8_t key) {
+        if(key >= sizeof(state.keyStates))
+            return;
+        if(state.lastKey == NO_LAST_KEY) {
+            state.lastKey = key;
+        }
+        state.keyStates[key] = true;
+    }
+
+    void c8_machine::release(uint8_t key) {
+        if(key >= sizeof(state.keyStates))
+            return;
+        state.keyStates[key] = false;
+    }
+
+    uint64_t c8_machine::hash() const {
+        uint64_t h = fnv1a(&state.pc, sizeof(state.pc));
+        h = fnv1a(&state.sp, sizeof(state.sp), h);
+        h = fnv1a(state.stack, sizeof(state.stack), h);
+        h = fnv1a(state.v, sizeof(state.v), h);
+        h = fnv1a(&state.I, sizeof(state.I), h);
+        h = fnv1a(&state.dt, sizeof(state.dt), h);
+        h = fnv1a(&state.st, sizeof(state.st), h);
+        h = fnv1a(state.rpl, sizeof(state.rpl), h);
+        h = fnv1a(&state.planes, sizeof(state.planes), h);
+        h = fnv1a(state.audioPattern, sizeof(state.audioPattern), h);
+        h = fnv1a(&state.pitch, sizeof(state.pitch), h);
+        h = fnv1a(state.ram, sizeof(state.ram), h);
+        h = fnv1a(&display.hires, sizeof(display.hires), h);
+        return display.hash(h);
+    }
+}
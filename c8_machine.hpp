@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <random>
+
+#include "c8_display.hpp"
+#include "c8_hardware_api.hpp"
+#include "c8_opcode_stats.hpp"
+#include "c8_paged_ram.hpp"
+#include "c8_profiler.hpp"
+#include "c8_quirks.hpp"
+#include "c8_state.hpp"
+#include "c8_tracer.hpp"
+
+namespace yac8 {
+    const int TIMER_FREQUENCY = 60;
+
+    /**
+     * Everything needed to put a c8_machine back exactly where it was. RAM is paged, so snapshots taken close
+     * together share most of their memory.
+     */
+    struct c8_machine_snapshot {
+        c8_paged_state state;
+        c8_display display;
+        std::mt19937 rng;
+        int timerPhase;
+        uint64_t cycle;
+        int processorSpeed;
+        c8_quirks quirks;
+        bool freezeTimers;
+    };
+
+    /**
+     * A complete, deterministic Chip-8 machine with no dependency on SDL or the wall clock.
+     * The 60Hz timers tick in guest time (every processorSpeed/60 cycles) and random numbers come from a seeded
+     * generator, so a given seed, quirk set and cycle-stamped input always reproduce the same run.
+     */
+    class c8_machine {
+        c8_hardware_api hardware_api{};
+        std::mt19937 rng{};
+        // accumulates TIMER_FREQUENCY per cycle, ticking the timers every time it passes processorSpeed
+        int timerPhase = 0;
+
+        // attached instrumentation. step() only looks at these when `instrumented` is set
+        c8_tracer *tracer = nullptr;
+        c8_profiler *profiler = nullptr;
+        c8_opcode_stats *opcodeStats = nullptr;
+        bool instrumented = false;
+
+        bool advance();
+        void updateInstrumented();
+        bool instrumentedStep();
+        void tickTimers();
+        // restores everything in a snapshot but the state
+        void restoreMachine(const c8_machine_snapshot &snapshot);
+
+        // re-executes history without feeding it to the instrumentation a second time
+        friend class c8_rewind;
+    public:
+        c8_state state{};
+        c8_display display{};
+        c8_quirks quirks{};
+        // guest cycles executed since the last reset
+        uint64_t cycle = 0;
+        int processorSpeed = 1000;
+        bool freezeTimers = false;
+
+        c8_machine();
+        // hardware_api refers back to this machine, so it may not be copied
+        c8_machine(const c8_machine &) = delete;
+        c8_machine &operator=(const c8_machine &) = delete;
+
+        void reset(const uint8_t *rom, int size, uint32_t seed);
+        // executes one instruction and advances guest time. Returns false iff the instruction was invalid
+        bool step();
+
+        // records every executed instruction while set, pass nullptr to detach
+        void setTracer(c8_tracer *t);
+        // counts executions while set, pass nullptr to detach
+        void setProfiler(c8_profiler *p);
+        // counts and samples the cost of each opcode class while set, pass nullptr to detach
+        void setOpcodeStats(c8_opcode_stats *s);
+
+        void save(c8_machine_snapshot &snapshot) const;
+        void restore(const c8_machine_snapshot &snapshot);
+        // restores a snapshot whose RAM this machine still holds apart from the pages written since it copied
+        // state.pageWrites into `pageWritesThen`, copying back only those (see c8_paged_state::storeWritten). RAM
+        // changed without going through c8_state::write() must have its pages' counts bumped by whoever changed it
+        void restoreWritten(const c8_machine_snapshot &snapshot, uint32_t pageWritesThen[PAGE_COUNT]);
+
+        // keys are 0-F, anything else is ignored
+        void press(uint8_t key);
+        void release(uint8_t key);
+
+        // hash of all guest-visible state: registers, RAM and framebuffer
+        uint64_t hash() const;
+    };
+}
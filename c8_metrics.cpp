@@ -0,0 +1,92 @@
+#include "c8_metrics.hpp"
+
+namespace yac8 {
+    void c8_metrics::recordFrame(const c8_frame_timings &timings) {
+        frameTotals.imgui += timings.imgui;
+        frameTotals.upload += timings.upload;
+        frameTotals.crt += timings.crt;
+        frameTotals.swap += timings.swap;
+        frameTotals.total += timings.total;
+        frames++;
+    }
+
+    bool c8_metrics::update(int processorSpeed, double audioQueuedMillis) {
+        clock::time_point now = clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastSample).count();
+        if(elapsed < interval)
+            return false;
+
+        uint64_t wait = lockWaitNanos.exchange(0, std::memory_order_relaxed);
+        uint64_t maxWait = maxLockWaitNanos.exchange(0, std::memory_order_relaxed);
+        uint64_t hold = lockHoldNanos.exchange(0, std::memory_order_relaxed);
+        uint64_t acquisitions = lockAcquisitions.exchange(0, std::memory_order_relaxed);
+        uint64_t currentCycle = cycle.load(std::memory_order_relaxed);
+        // the machine was reset if its cycle count went backwards
+        uint64_t cycles = currentCycle >= lastCycle ? currentCycle - lastCycle : currentCycle;
+
+        c8_metrics_sample sample{};
+        sample.seconds = std::chrono::duration<double>(now - started).count();
+        sample.cyclesPerSecond = cycles / elapsed;
+        sample.processorSpeed = processorSpeed;
+        sample.emulationBusy = hold / 1e9 / elapsed;
+        if(acquisitions != 0) {
+            sample.lockWaitMicros = wait / 1e3 / acquisitions;
+            sample.lockHoldMicros = hold / 1e3 / acquisitions;
+        }
+        sample.maxLockWaitMicros = maxWait / 1e3;
+        if(frames != 0) {
+            sample.frameMillis = frameTotals.total * 1e3 / frames;
+            sample.imguiMillis = frameTotals.imgui * 1e3 / frames;
+            sample.uploadMillis = frameTotals.upload * 1e3 / frames;
+            sample.crtMillis = frameTotals.crt * 1e3 / frames;
+            sample.swapMillis = frameTotals.swap * 1e3 / frames;
+        }
+        sample.audioQueuedMillis = audioQueuedMillis;
+
+        latest = sample;
+        if(log.is_open())
+            write(sample);
+
+        lastSample = now;
+        lastCycle = currentCycle;
+        frameTotals = {};
+        frames = 0;
+        return true;
+    }
+
+    bool c8_metrics::startLog(const std::string &path) {
+        stopLog();
+        log.open(path, std::ios::out | std::ios::trunc);
+        if(!log.is_open())
+            return false;
+        json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        if(!json) {
+            log << "seconds,cycles_per_second,processor_speed,emulation_busy,lock_wait_us,max_lock_wait_us,lock_hold_us,"
+                   "frame_ms,imgui_ms,upload_ms,crt_ms,swap_ms,audio_queued_ms\n";
+        }
+        return true;
+    }
+
+    void c8_metrics::stopLog() {
+        if(log.is_open())
+            log.close();
+    }
+
+    void c8_metrics::write(const c8_metrics_sample &s) {
+        if(json) {
+            log << "{\"seconds\":" << s.seconds << ",\"cycles_per_second\":" << s.cyclesPerSecond
+                << ",\"processor_speed\":" << s.processorSpeed << ",\"emulation_busy\":" << s.emulationBusy
+                << ",\"lock_wait_us\":" << s.lockWaitMicros << ",\"max_lock_wait_us\":" << s.maxLockWaitMicros
+                << ",\"lock_hold_us\":" << s.lockHoldMicros << ",\"frame_ms\":" << s.frameMillis
+                << ",\"imgui_ms\":" << s.imguiMillis << ",\"upload_ms\":" << s.uploadMillis
+                << ",\"crt_ms\":" << s.crtMillis << ",\"swap_ms\":" << s.swapMillis
+                << ",\"audio_queued_ms\":" << s.audioQueuedMillis << "}\n";
+        } else {
+            log << s.seconds << "," << s.cyclesPerSecond << "," << s.processorSpeed << "," << s.emulationBusy << ","
+                << s.lockWaitMicros << "," << s.maxLockWaitMicros << "," << s.lockHoldMicros << ","
+                << s.frameMillis << "," << s.imguiMillis << "," << s.uploadMillis << "," << s.crtMillis << ","
+                << s.swapMillis << "," << s.audioQueuedMillis << "\n";
+        }
+        log.flush();
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+namespace yac8 {
+    /**
+     * Where the UI thread's time went in one rendered frame, in seconds.
+     */
+    struct c8_frame_timings {
+        double imgui = 0;
+        double upload = 0;
+        double crt = 0;
+        double swap = 0;
+        double total = 0;
+    };
+
+    /**
+     * Runtime performance over the last sampling interval. Times are means per lock acquisition or per frame.
+     */
+    struct c8_metrics_sample {
+        double seconds = 0;
+        double cyclesPerSecond = 0;
+        int processorSpeed = 0;
+        // fraction of wall time the emulation thread spent holding the state lock, i.e. emulating
+        double emulationBusy = 0;
+        double lockWaitMicros = 0;
+        double maxLockWaitMicros = 0;
+        double lockHoldMicros = 0;
+        double frameMillis = 0;
+        double imguiMillis = 0;
+        double uploadMillis = 0;
+        double crtMillis = 0;
+        double swapMillis = 0;
+        // sound generated by the emulator but not played yet
+        double audioQueuedMillis = 0;
+    };
+
+    /**
+     * Collects where time goes at runtime: the emulation thread reports its lock timings lock-free, the UI thread
+     * reports its frame timings and turns it all into a c8_metrics_sample once per interval, optionally logged to
+     * a CSV or JSON-lines file.
+     */
+    class c8_metrics {
+        typedef std::chrono::steady_clock clock;
+
+        // written by the emulation thread
+        std::atomic<uint64_t> lockWaitNanos{0};
+        std::atomic<uint64_t> maxLockWaitNanos{0};
+        std::atomic<uint64_t> lockHoldNanos{0};
+        std::atomic<uint64_t> lockAcquisitions{0};
+        std::atomic<uint64_t> cycle{0};
+
+        // owned by the UI thread
+        clock::time_point started = clock::now();
+        clock::time_point lastSample = started;
+        uint64_t lastCycle = 0;
+        c8_frame_timings frameTotals{};
+        int frames = 0;
+        std::ofstream log;
+        bool json = false;
+
+        void write(const c8_metrics_sample &sample);
+    public:
+        double interval = 1.0;
+        c8_metrics_sample latest{};
+
+        // emulation thread: one lock acquisition, and the guest cycle it left the machine at
+        void recordLock(uint64_t waitNanos, uint64_t holdNanos, uint64_t guestCycle) {
+            lockWaitNanos.fetch_add(waitNanos, std::memory_order_relaxed);
+            lockHoldNanos.fetch_add(holdNanos, std::memory_order_relaxed);
+            lockAcquisitions.fetch_add(1, std::memory_order_relaxed);
+            if(waitNanos > maxLockWaitNanos.load(std::memory_order_relaxed))
+                maxLockWaitNanos.store(waitNanos, std::memory_order_relaxed);
+            cycle.store(guestCycle, std::memory_order_relaxed);
+        }
+
+        // UI thread
+        void recordFrame(const c8_frame_timings &timings);
+        // publishes a new `latest` sample once every `interval` seconds, returning true when it does
+        bool update(int processorSpeed, double audioQueuedMillis);
+
+        // logs every sample to `path`, as JSON lines if it ends in .json and as CSV otherwise
+        bool startLog(const std::string &path);
+        void stopLog();
+        bool isLogging() const { return log.is_open(); }
+    };
+}
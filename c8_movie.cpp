@@ -0,0 +1,181 @@
+#include "c8_movie.hpp"
+#include "c8_hash.hpp"
+
+#include <chrono>
+
+namespace yac8 {
+    // file layout, all little-endian:
+    //   "YAC8MOVI", u32 version, u32 seed, u16 quirks, u16 processorSpeed, u64 romHash
+    //   followed by events: u64 cycle, u8 kind, u8 key, u16 value
+    const char MOVIE_MAGIC[8] = {'Y','A','C','8','M','O','V','I'};
+    const uint32_t MOVIE_VERSION = 1;
+
+    static void put(std::ostream &out, uint64_t value, int bytes) {
+        char buffer[8];
+        for(int i = 0; i < bytes; i++) {
+            buffer[i] = static_cast<char>(value >> (8 * i));
+        }
+        out.write(buffer, bytes);
+    }
+
+    static bool get(std::istream &in, uint64_t &value, int bytes) {
+        unsigned char buffer[8];
+        if(!in.read(reinterpret_cast<char *>(buffer), bytes))
+            return false;
+        value = 0;
+        for(int i = 0; i < bytes; i++) {
+            value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+        }
+        return true;
+    }
+
+    // whether an event read from a file is one applyMovieEvent() can apply
+    static bool validMovieEvent(const c8_movie_event &event) {
+        switch(event.kind) {
+            case MOVIE_KEY_DOWN:
+            case MOVIE_KEY_UP:
+                return event.key < 16;
+            case MOVIE_SPEED:
+                // the timers divide by it
+                return event.value != 0;
+            case MOVIE_QUIRKS:
+            case MOVIE_END:
+            case MOVIE_FREEZE_TIMERS:
+                return true;
+        }
+        return false;
+    }
+
+    static void putEvent(std::ostream &out, const c8_movie_event &event) {
+        put(out, event.cycle, 8);
+        put(out, event.kind, 1);
+        put(out, event.key, 1);
+        put(out, event.value, 2);
+    }
+
+    bool c8_movie::load(const std::string &path) {
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        char magic[sizeof(MOVIE_MAGIC)];
+        if(!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MOVIE_MAGIC))
+            return false;
+
+        uint64_t version, value;
+        if(!get(in, version, 4) || version != MOVIE_VERSION)
+            return false;
+        if(!get(in, value, 4)) return false;
+        seed = static_cast<uint32_t>(value);
+        if(!get(in, value, 2)) return false;
+        quirks = unpackQuirks(static_cast<uint16_t>(value));
+        if(!get(in, value, 2)) return false;
+        processorSpeed = static_cast<int>(value);
+        if(processorSpeed == 0) return false;
+        if(!get(in, romHash, 8)) return false;
+
+        events.clear();
+        c8_movie_event event{};
+        uint64_t kind, key;
+        while(get(in, event.cycle, 8) && get(in, kind, 1) && get(in, key, 1) && get(in, value, 2)) {
+            event.kind = static_cast<uint8_t>(kind);
+            event.key = static_cast<uint8_t>(key);
+            event.value = static_cast<uint16_t>(value);
+            if(!validMovieEvent(event))
+                return false;
+            events.push_back(event);
+        }
+        return true;
+    }
+
+    bool c8_movie::play(c8_machine &machine, const uint8_t *rom, int size) const {
+        if(fnv1a(rom, size) != romHash)
+            return false;
+
+        machine.reset(rom, size, seed);
+        machine.quirks = quirks;
+        machine.processorSpeed = processorSpeed;
+        machine.freezeTimers = false;
+
+        for(const c8_movie_event &event : events) {
+            while(machine.cycle < event.cycle) {
+                machine.step();
+            }
+            if(event.kind == MOVIE_END)
+                return true;
+            applyMovieEvent(machine, event);
+        }
+        return true;
+    }
+
+    void applyMovieEvent(c8_machine &machine, const c8_movie_event &event) {
+        switch(event.kind) {
+            case MOVIE_KEY_DOWN: machine.press(event.key); break;
+            case MOVIE_KEY_UP: machine.release(event.key); break;
+            case MOVIE_SPEED:
+                if(event.value != 0)
+                    machine.processorSpeed = event.value;
+                break;
+            case MOVIE_QUIRKS: machine.quirks = unpackQuirks(event.value); break;
+            case MOVIE_FREEZE_TIMERS: machine.freezeTimers = event.value != 0; break;
+        }
+    }
+
+    c8_movie_recorder::~c8_movie_recorder() {
+        if(recording)
+            stop(0);
+    }
+
+    bool c8_movie_recorder::start(const std::string &path, const c8_movie &header) {
+        if(recording)
+            return false;
+        out.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!out.is_open())
+            return false;
+
+        out.write(MOVIE_MAGIC, sizeof(MOVIE_MAGIC));
+        put(out, MOVIE_VERSION, 4);
+        put(out, header.seed, 4);
+        put(out, packQuirks(header.quirks), 2);
+        put(out, static_cast<uint64_t>(header.processorSpeed), 2);
+        put(out, header.romHash, 8);
+
+        writing = true;
+        recording = true;
+        writer = std::thread([this]() { writerThread(); });
+        return true;
+    }
+
+    void c8_movie_recorder::record(const c8_movie_event &event) {
+        if(!recording)
+            return;
+        while(!ring->push(event)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void c8_movie_recorder::stop(uint64_t cycle) {
+        if(!recording)
+            return;
+        recording = false;
+        c8_movie_event end{cycle, MOVIE_END, 0, 0};
+        while(!ring->push(end)) {
+            std::this_thread::yield();
+        }
+        writing = false;
+        writer.join();
+    }
+
+    void c8_movie_recorder::writerThread() {
+        c8_movie_event event;
+        while(true) {
+            // check before draining, so that everything pushed before stop() is written
+            bool finishing = !writing;
+            while(ring->pop(event)) {
+                putEvent(out, event);
+            }
+            out.flush();
+            if(finishing)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        out.close();
+    }
+}
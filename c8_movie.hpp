@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "c8_machine.hpp"
+#include "c8_quirks.hpp"
+#include "c8_ring_buffer.hpp"
+
+namespace yac8 {
+    enum c8_movie_event_kind : uint8_t {
+        MOVIE_KEY_DOWN = 0,
+        MOVIE_KEY_UP = 1,
+        // `value` holds the new processorSpeed
+        MOVIE_SPEED = 2,
+        // `value` holds the new quirks, see packQuirks()
+        MOVIE_QUIRKS = 3,
+        // marks the cycle the recording stopped at
+        MOVIE_END = 4,
+        // `value` is 1 if the debugger froze the timers, 0 if it let them run again
+        MOVIE_FREEZE_TIMERS = 5
+    };
+
+    /**
+     * Something that happened to the machine from the outside, stamped with the guest cycle it happened on.
+     */
+    struct c8_movie_event {
+        uint64_t cycle;
+        uint8_t kind;
+        uint8_t key;
+        uint16_t value;
+    };
+
+    // applies an event to the machine. MOVIE_END does nothing
+    void applyMovieEvent(c8_machine &machine, const c8_movie_event &event);
+
+    /**
+     * A recorded session: everything needed to deterministically reproduce it on a c8_machine.
+     */
+    struct c8_movie {
+        uint32_t seed = 0;
+        c8_quirks quirks{};
+        int processorSpeed = 1000;
+        uint64_t romHash = 0;
+        std::vector<c8_movie_event> events;
+
+        // returns false unless the whole file is a valid movie: no keys past F, no unknown events, no speed of 0
+        bool load(const std::string &path);
+        // replays the movie as fast as possible. Returns false if the ROM isn't the one that was recorded
+        bool play(c8_machine &machine, const uint8_t *rom, int size) const;
+    };
+
+    /**
+     * Streams a movie to disk. record() is lock-free and meant for the emulation thread; events are written out by a
+     * background thread so that disk I/O never stalls emulation. A movie missing an event would desync on replay, so
+     * in the unlikely case the ring fills up, record() waits for the writer rather than drop one.
+     */
+    class c8_movie_recorder {
+        typedef c8_ring_buffer<c8_movie_event, 1 << 14> event_ring;
+
+        std::unique_ptr<event_ring> ring{new event_ring()};
+        std::ofstream out;
+        std::thread writer;
+        std::atomic<bool> recording{false};
+        std::atomic<bool> writing{false};
+
+        void writerThread();
+    public:
+        ~c8_movie_recorder();
+
+        bool start(const std::string &path, const c8_movie &header);
+        void record(const c8_movie_event &event);
+        // stops recording at the given cycle, and waits for the writer to finish
+        void stop(uint64_t cycle);
+
+        bool isRecording() const { return recording; }
+    };
+}
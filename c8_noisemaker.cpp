@@ -1,63 +1,111 @@
 #include "c8_noisemaker.hpp"
+#include "c8_trace_events.hpp"
 
 #include <SDL_audio.h>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 
 
 namespace yac8 {
+    // the classic beep: two square waves an octave apart, at pitch 1.0
+    const double TONE_FREQUENCY = 128.2;
+    const double TONE_AMPLITUDE = 200.0;
+    // the top of the pitch slider, which the wavetable's harmonics are limited for
+    const double MAX_PITCH = 3.0;
+    // XO-CHIP audio patterns play at 4000 bits per second at DEFAULT_AUDIO_PITCH, an octave up every 48 steps
+    const double PATTERN_RATE = 4000.0;
 
-    c8_noisemaker::c8_noisemaker() {
-        audio_spec = {};
-        audio_spec.freq=64100;
-        audio_spec.format=AUDIO_S16SYS;
-        audio_spec.channels=1;
-        audio_spec.samples=1024;
-        audio_spec.callback=nullptr;
-
-        // minimum size of queue to maintain, if we are to continue looping without breaks
-        minReserve = minimumReserveRatio * audio_spec.freq;
-        queueFillingBuffer = new Uint16[(int)minReserve];
-
-        // opening an audio device:
-        audio_device = SDL_OpenAudioDevice(NULL, 0, &audio_spec, NULL, 0);
-        // unpausing the audio device (starts playing):
+    c8_noisemaker::c8_noisemaker(c8_sound_channel &channel) : channel(channel) {
+        SDL_AudioSpec desired = {};
+        desired.freq=48000;
+        desired.format=AUDIO_S16SYS;
+        desired.channels=1;
+        desired.samples=512;
+        desired.callback=callback;
+        desired.userdata=this;
+
+        // opening an audio device, accepting whatever rate it prefers:
+        audio_device = SDL_OpenAudioDevice(NULL, 0, &desired, &audio_spec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+        if(audio_device == 0)
+            audio_spec = desired;
+
+        // sum the odd harmonics of both square waves that stay below Nyquist even at MAX_PITCH, so the table
+        // doesn't alias however it is resampled
+        const double pi = 3.14159265358979323846;
+        int harmonics = (int) (audio_spec.freq / 2 / (TONE_FREQUENCY * 2 * MAX_PITCH));
+        for(int i = 0; i < WAVETABLE_SIZE; i++) {
+            double t = 2 * pi * i / WAVETABLE_SIZE;
+            double sample = 0;
+            for(int k = 1; k <= harmonics; k += 2) {
+                sample += std::sin(k * t) / k + std::sin(2 * k * t) / k;
+            }
+            wavetable[i] = (float) (sample * 4 / pi);
+        }
+
+        // unpausing the audio device (starts the callback):
         SDL_PauseAudioDevice(audio_device, 0);
     }
 
-    float squareWave(float x) {
-        return ((int)x % 2) * 2 - 1;
+    void SDLCALL c8_noisemaker::callback(void *userdata, Uint8 *stream, int len) {
+        static_cast<c8_noisemaker *>(userdata)->fill(reinterpret_cast<int16_t *>(stream), len / (int) sizeof(int16_t));
     }
 
-    void c8_noisemaker::play() {
-        if(!playing) {
-            playing = true;
-            SDL_PauseAudioDevice(audio_device, 0);
-        }
-        Uint32 queuedSound = SDL_GetQueuedAudioSize(audio_device);
-        if(queuedSound < minReserve) {
-            // fill sound queue to desired size
-            Uint32 soundToAdd = minReserve - queuedSound;
-            if (soundToAdd > 0) {
-                for (int i = 0; i < soundToAdd; i++) {
-                    queueFillingBuffer[i] = (squareWave(x * 0.4 * pitch) + squareWave(x * 0.8 * pitch)) * 200 * volume;
-                    x += .010f;
+    void c8_noisemaker::fill(int16_t *samples, int count) {
+        YAC8_TRACE_SCOPE("audio callback");
+        double cyclesPerSample = (double) channel.processorSpeed.load(std::memory_order_relaxed) / audio_spec.freq;
+        uint64_t latest = channel.cycle.load(std::memory_order_acquire);
+        double bufferCycles = count * cyclesPerSample;
+
+        // play guest time behind the emulator, so an edge is queued before its sample is rendered: two buffers, or
+        // the pacing lead. Without pacing, drift is pulled in gently. With it, the emulator follows us instead.
+        // Either way a jump (reset, rewind, pause, a stall) is followed immediately
+        bool pacing = channel.pacing.load(std::memory_order_relaxed);
+        double lead = pacing ? (double) channel.lead.load(std::memory_order_relaxed) : 2 * bufferCycles;
+        double target = (double) latest - lead;
+        if(!synced || std::abs(playhead - target) > 4 * bufferCycles + lead)
+            playhead = target;
+        else if(!pacing)
+            playhead += (target - playhead) / 16;
+        synced = true;
+
+        bool testing = this->testing.load(std::memory_order_relaxed);
+        float amplitude = (float) TONE_AMPLITUDE * volume.load(std::memory_order_relaxed);
+        uint32_t increment = (uint32_t) (TONE_FREQUENCY * pitch.load(std::memory_order_relaxed) / audio_spec.freq * 4294967296.0);
+        for(int i = 0; i < count; i++) {
+            // apply every edge due by this sample. Fresh edges are up to `lead` ahead of the playhead, so one
+            // implausibly far beyond that predates a reset or rewind
+            double now = playhead + i * cyclesPerSample;
+            while(hasNext || (hasNext = channel.edges.pop(next))) {
+                if(next.cycle > now && next.cycle <= now + lead + 8 * bufferCycles)
+                    break;
+                on = next.on;
+                if(on) {
+                    voice = next;
+                    double rate = PATTERN_RATE * std::pow(2.0, (voice.pitch - DEFAULT_AUDIO_PITCH) / 48.0);
+                    patternIncrement = (uint32_t) (rate / AUDIO_PATTERN_SIZE / 8 / audio_spec.freq * 4294967296.0);
                 }
-                SDL_QueueAudio(audio_device, queueFillingBuffer, sizeof(int16_t) * soundToAdd);
+                hasNext = false;
             }
-        }
-    }
 
-    void c8_noisemaker::stop() {
-        if(playing) {
-            playing = false;
-            x = 0.0f;
-            SDL_ClearQueuedAudio(audio_device);
-            SDL_PauseAudioDevice(audio_device,1);
+            float target = on || testing ? 1.0f : 0.0f;
+            if(level != target)
+                level = target > level ? std::min(1.0f, level + 1.0f / RAMP_SAMPLES) : std::max(0.0f, level - 1.0f / RAMP_SAMPLES);
+            float sample;
+            if(voice.patterned && !testing) {
+                uint32_t bit = patternPhase >> 25;
+                sample = (voice.pattern[bit >> 3] >> (7 - (bit & 7))) & 1 ? 1.0f : -1.0f;
+                patternPhase += patternIncrement;
+            } else {
+                sample = wavetable[phase >> (32 - WAVETABLE_BITS)];
+                phase += increment;
+            }
+            samples[i] = (int16_t) (sample * amplitude * level);
         }
+        playhead += bufferCycles;
+        channel.played.store(playhead > 0 ? (uint64_t) playhead : 0, std::memory_order_release);
     }
 
     c8_noisemaker::~c8_noisemaker() {
-        delete[] queueFillingBuffer;
-        SDL_CloseAudio();
+        SDL_CloseAudioDevice(audio_device);
     }
-}
\ No newline at end of file
+}
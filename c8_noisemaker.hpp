@@ -1,29 +1,97 @@
 #pragma once
 
 #include <SDL_audio.h>
+#include <atomic>
+#include <stdint.h>
+
+#include "c8_ring_buffer.hpp"
+#include "c8_state.hpp"
 
 namespace yac8 {
     /**
-     * A class for playing a square-wave beep continuously, using SDL2's Audio Queue API
+     * The sound timer becoming non-zero (on) or zero (off), at a guest cycle. An XO-CHIP program that loaded an
+     * audio pattern plays that at its pitch instead of the beep, and changing either while on is an edge as well.
+     */
+    struct c8_sound_edge {
+        uint64_t cycle;
+        bool on;
+        bool patterned = false;
+        uint8_t pitch = DEFAULT_AUDIO_PITCH;
+        uint8_t pattern[AUDIO_PATTERN_SIZE] = {0};
+    };
+
+    /**
+     * What the emulation thread tells the audio callback, without locking: sound edges as they happen, and how far
+     * guest time has got, so the callback can place each edge at the right sample.
+     */
+    struct c8_sound_channel {
+        c8_ring_buffer<c8_sound_edge, 1024> edges{};
+        // guest cycle at the end of the last emulation slice, and the cycles/s guest time advances at
+        std::atomic<uint64_t> cycle{0};
+        std::atomic<int> processorSpeed{1000};
+
+        // audio pacing: the callback plays guest time at the device's own rate, and the emulation thread keeps
+        // `lead` cycles ahead of `played`. Otherwise the callback follows the emulator
+        std::atomic<bool> pacing{false};
+        std::atomic<uint64_t> lead{0};
+        // guest cycle the callback has rendered up to
+        std::atomic<uint64_t> played{0};
+    };
+
+    /**
+     * A class for playing the square-wave beep, or an XO-CHIP audio pattern, synthesized on SDL2's audio thread.
+     * The callback replays the sound edges in `channel` a little behind the emulator, at the sample their guest
+     * cycle falls on, so even beeps shorter than a frame are placed exactly.
      */
     class c8_noisemaker {
+    public:
+        static const int WAVETABLE_BITS = 11;
+        static const int WAVETABLE_SIZE = 1 << WAVETABLE_BITS;
+        // samples a beep fades in and out over, to avoid clicks
+        static const int RAMP_SAMPLES = 64;
+
     private:
         SDL_AudioSpec audio_spec;
         SDL_AudioDeviceID audio_device;
-        int framerate = 60;
-        bool playing = false;
-        float x = 0;
+        c8_sound_channel &channel;
+        std::atomic<bool> testing{false};
+
+        // one period of the tone, band-limited for the highest pitch
+        float wavetable[WAVETABLE_SIZE];
 
-        const double minimumReserveRatio = 1.0 / 10.0;
-        double minReserve = 0.0;
+        // callback thread only: 32-bit fixed-point position in the wavetable, and the current fade level
+        uint32_t phase = 0;
+        float level = 0.0f;
+        // position in the 128-bit audio pattern, the top 7 bits being the bit playing, and its step per sample
+        uint32_t patternPhase = 0;
+        uint32_t patternIncrement = 0;
+        // the guest cycle the next sample plays, whether the sound timer is on there, and the first edge not yet
+        // reached
+        double playhead = 0;
+        bool synced = false;
+        bool on = false;
+        // the last edge that turned the sound on, whose voice keeps playing while the fade out finishes
+        c8_sound_edge voice{0, false};
+        c8_sound_edge next{0, false};
+        bool hasNext = false;
 
-        Uint16 *queueFillingBuffer;
+        static void SDLCALL callback(void *userdata, Uint8 *stream, int len);
+        void fill(int16_t *samples, int count);
     public:
-        float volume = 1.0f;
-        float pitch = 1.0f;
-        c8_noisemaker();
+        std::atomic<float> volume{1.0f};
+        std::atomic<float> pitch{1.0f};
+
+        // `channel` is read from the audio thread, so it must outlive the noisemaker
+        explicit c8_noisemaker(c8_sound_channel &channel);
         ~c8_noisemaker();
-        void play();
-        void stop();
+        // plays regardless of the sound timer while set, for the buzzer settings' Test button
+        void test(bool on) { testing.store(on, std::memory_order_relaxed); }
+        // guest time the emulator has run but the callback hasn't played yet, in milliseconds
+        double queuedMillis() const {
+            uint64_t cycle = channel.cycle.load(std::memory_order_acquire);
+            uint64_t played = channel.played.load(std::memory_order_acquire);
+            int speed = channel.processorSpeed.load(std::memory_order_relaxed);
+            return cycle > played && speed > 0 ? (cycle - played) * 1000.0 / speed : 0.0;
+        }
     };
 }
@@ -0,0 +1,80 @@
+#include "c8_opcode_stats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace yac8 {
+    static int64_t wallNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    c8_opcode_stats::c8_opcode_stats() {
+        reset();
+    }
+
+    uint64_t c8_opcode_stats::ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(wallNanos());
+#endif
+    }
+
+    void c8_opcode_stats::reset() {
+        std::fill(counts, counts + OP_COUNT, 0);
+        std::fill(samples, samples + OP_COUNT, 0);
+        std::fill(sampledTicks, sampledTicks + OP_COUNT, 0);
+        std::fill(&histogram[0][0], &histogram[0][0] + OP_COUNT * COST_HISTOGRAM_BUCKETS, 0);
+        countdown = samplePeriod;
+
+        timerOverhead = UINT64_MAX;
+        for(int i = 0; i < 64; i++) {
+            uint64_t start = ticks();
+            timerOverhead = std::min(timerOverhead, ticks() - start);
+        }
+        calibrationTicks = ticks();
+        calibrationNanos = wallNanos();
+    }
+
+    double c8_opcode_stats::nanosPerTick() const {
+        uint64_t elapsedTicks = ticks() - calibrationTicks;
+        int64_t elapsedNanos = wallNanos() - calibrationNanos;
+        if(elapsedTicks == 0 || elapsedNanos <= 0)
+            return 1.0;
+        return static_cast<double>(elapsedNanos) / static_cast<double>(elapsedTicks);
+    }
+
+    double c8_opcode_stats::meanNanos(c8_opcode_class op) const {
+        if(samples[op] == 0)
+            return 0.0;
+        return nanosPerTick() * static_cast<double>(sampledTicks[op]) / static_cast<double>(samples[op]);
+    }
+
+    bool c8_opcode_stats::writeCSV(const std::string &path) const {
+        std::ofstream os(path, std::ios::out | std::ios::trunc);
+        if(!os.is_open())
+            return false;
+        os << "opcode,count,samples,mean_ns";
+        for(int b = 0; b < COST_HISTOGRAM_BUCKETS; b++) {
+            os << ",ticks_" << (1ULL << b);
+        }
+        os << "\n";
+        for(int op = 0; op < OP_COUNT; op++) {
+            os << "\"" << OPCODE_NAMES[op] << "\"," << counts[op] << "," << samples[op] << ","
+               << meanNanos(static_cast<c8_opcode_class>(op));
+            for(int b = 0; b < COST_HISTOGRAM_BUCKETS; b++) {
+                os << "," << histogram[op][b];
+            }
+            os << "\n";
+        }
+        return true;
+    }
+}
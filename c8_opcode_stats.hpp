@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "c8_opcodes.hpp"
+
+namespace yac8 {
+    const int COST_HISTOGRAM_BUCKETS = 16;
+
+    /**
+     * Counts every executed instruction by opcode class, and times a sampled subset of them with the cheapest timer
+     * the host has (rdtsc on x86), to show which instructions the host actually spends its time on.
+     */
+    class c8_opcode_stats {
+        uint32_t countdown = 1;
+        // rdtsc ticks aren't nanoseconds; they're converted using the wall clock elapsed since reset()
+        uint64_t calibrationTicks = 0;
+        int64_t calibrationNanos = 0;
+        // the cost of reading the timer twice, subtracted from every sample
+        uint64_t timerOverhead = 0;
+    public:
+        uint64_t counts[OP_COUNT] = {0};
+        uint64_t samples[OP_COUNT] = {0};
+        uint64_t sampledTicks[OP_COUNT] = {0};
+        // bucket b counts samples that took [2^b, 2^(b+1)) timer ticks
+        uint64_t histogram[OP_COUNT][COST_HISTOGRAM_BUCKETS] = {{0}};
+        // one in this many instructions is timed
+        uint32_t samplePeriod = 61;
+
+        c8_opcode_stats();
+        void reset();
+
+        static uint64_t ticks();
+        double nanosPerTick() const;
+
+        // true if the next instruction should be timed
+        bool sampleNext() {
+            if(--countdown != 0)
+                return false;
+            countdown = samplePeriod;
+            return true;
+        }
+
+        void count(c8_opcode_class op) {
+            counts[op]++;
+        }
+
+        void sample(c8_opcode_class op, uint64_t elapsedTicks) {
+            elapsedTicks = elapsedTicks > timerOverhead ? elapsedTicks - timerOverhead : 0;
+            samples[op]++;
+            sampledTicks[op] += elapsedTicks;
+            int bucket = 0;
+            while(elapsedTicks > 1 && bucket < COST_HISTOGRAM_BUCKETS - 1) {
+                elapsedTicks >>= 1;
+                bucket++;
+            }
+            histogram[op][bucket]++;
+        }
+
+        // average host nanoseconds per sampled instruction of this class
+        double meanNanos(c8_opcode_class op) const;
+        // one row per opcode class: counts, mean cost, and the cost histogram (in timer ticks)
+        bool writeCSV(const std::string &path) const;
+    };
+}
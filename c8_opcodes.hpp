@@ -0,0 +1,207 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace yac8 {
+    /**
+     * Every instruction class c8_state::step dispatches on, plus `SYS addr` (which the core treats as invalid).
+     * The SUPER-CHIP and then XO-CHIP additions follow the Chip-8 set, so existing classes keep their values.
+     */
+    enum c8_opcode_class : uint8_t {
+        OP_SYS,         // 0nnn
+        OP_CLS,         // 00E0
+        OP_RET,         // 00EE
+        OP_JP,          // 1nnn
+        OP_CALL,        // 2nnn
+        OP_SE_BYTE,     // 3xkk
+        OP_SNE_BYTE,    // 4xkk
+        OP_SE_REG,      // 5xy0
+        OP_LD_BYTE,     // 6xkk
+        OP_ADD_BYTE,    // 7xkk
+        OP_LD_REG,      // 8xy0
+        OP_OR,          // 8xy1
+        OP_AND,         // 8xy2
+        OP_XOR,         // 8xy3
+        OP_ADD_REG,     // 8xy4
+        OP_SUB,         // 8xy5
+        OP_SHR,         // 8xy6
+        OP_SUBN,        // 8xy7
+        OP_SHL,         // 8xyE
+        OP_SNE_REG,     // 9xy0
+        OP_LD_I,        // Annn
+        OP_JP_V0,       // Bnnn
+        OP_RND,         // Cxkk
+        OP_DRW,         // Dxyn
+        OP_SKP,         // Ex9E
+        OP_SKNP,        // ExA1
+        OP_LD_VX_DT,    // Fx07
+        OP_LD_VX_K,     // Fx0A
+        OP_LD_DT_VX,    // Fx15
+        OP_LD_ST_VX,    // Fx18
+        OP_ADD_I,       // Fx1E
+        OP_LD_F,        // Fx29
+        OP_LD_B,        // Fx33
+        OP_LD_MEM_VX,   // Fx55
+        OP_LD_VX_MEM,   // Fx65
+        OP_SCD,         // 00Cn
+        OP_SCR,         // 00FB
+        OP_SCL,         // 00FC
+        OP_EXIT,        // 00FD
+        OP_LOW,         // 00FE
+        OP_HIGH,        // 00FF
+        OP_LD_HF,       // Fx30
+        OP_LD_R_VX,     // Fx75
+        OP_LD_VX_R,     // Fx85
+        OP_SCU,         // 00Dn
+        OP_SAVE_RANGE,  // 5xy2
+        OP_LOAD_RANGE,  // 5xy3
+        OP_LD_I_LONG,   // F000 nnnn
+        OP_PLANE,       // Fn01
+        OP_AUDIO,       // F002
+        OP_PITCH,       // Fx3A
+        OP_INVALID,
+        OP_COUNT
+    };
+
+    const char *const OPCODE_NAMES[OP_COUNT] = {
+        "SYS addr", "CLS", "RET", "JP addr", "CALL addr", "SE Vx, byte", "SNE Vx, byte", "SE Vx, Vy",
+        "LD Vx, byte", "ADD Vx, byte", "LD Vx, Vy", "OR Vx, Vy", "AND Vx, Vy", "XOR Vx, Vy", "ADD Vx, Vy",
+        "SUB Vx, Vy", "SHR Vx", "SUBN Vx, Vy", "SHL Vx", "SNE Vx, Vy", "LD I, addr", "JP V0, addr",
+        "RND Vx, byte", "DRW Vx, Vy, n", "SKP Vx", "SKNP Vx", "LD Vx, DT", "LD Vx, K", "LD DT, Vx",
+        "LD ST, Vx", "ADD I, Vx", "LD F, Vx", "LD B, Vx", "LD [I], Vx", "LD Vx, [I]",
+        "SCD n", "SCR", "SCL", "EXIT", "LOW", "HIGH", "LD HF, Vx", "LD R, Vx", "LD Vx, R",
+        "SCU n", "LD [I], Vx-Vy", "LD Vx-Vy, [I]", "LD I, long addr", "PLANE n", "AUDIO", "PITCH Vx", "invalid"
+    };
+
+    // classifies an instruction exactly the way c8_state::step decodes it
+    inline c8_opcode_class classifyOpcode(uint16_t instruction) {
+        switch(instruction & 0xF000) {
+            case 0x0000:
+                if((instruction & 0x00F0) == 0x00C0)
+                    return OP_SCD;
+                if((instruction & 0x00F0) == 0x00D0)
+                    return OP_SCU;
+                switch(instruction & 0x00FF) {
+                    case 0x00E0: return OP_CLS;
+                    case 0x00EE: return OP_RET;
+                    case 0x00FB: return OP_SCR;
+                    case 0x00FC: return OP_SCL;
+                    case 0x00FD: return OP_EXIT;
+                    case 0x00FE: return OP_LOW;
+                    case 0x00FF: return OP_HIGH;
+                    default: return OP_SYS;
+                }
+            case 0x1000: return OP_JP;
+            case 0x2000: return OP_CALL;
+            case 0x3000: return OP_SE_BYTE;
+            case 0x4000: return OP_SNE_BYTE;
+            case 0x5000:
+                switch(instruction & 0x000F) {
+                    case 0x0002: return OP_SAVE_RANGE;
+                    case 0x0003: return OP_LOAD_RANGE;
+                    default: return OP_SE_REG;
+                }
+            case 0x6000: return OP_LD_BYTE;
+            case 0x7000: return OP_ADD_BYTE;
+            case 0x8000:
+                switch(instruction & 0x000F) {
+                    case 0x0000: return OP_LD_REG;
+                    case 0x0001: return OP_OR;
+                    case 0x0002: return OP_AND;
+                    case 0x0003: return OP_XOR;
+                    case 0x0004: return OP_ADD_REG;
+                    case 0x0005: return OP_SUB;
+                    case 0x0006: return OP_SHR;
+                    case 0x0007: return OP_SUBN;
+                    case 0x000E: return OP_SHL;
+                    default: return OP_INVALID;
+                }
+            case 0x9000: return OP_SNE_REG;
+            case 0xA000: return OP_LD_I;
+            case 0xB000: return OP_JP_V0;
+            case 0xC000: return OP_RND;
+            case 0xD000: return OP_DRW;
+            case 0xE000:
+                switch(instruction & 0x00FF) {
+                    case 0x009E: return OP_SKP;
+                    case 0x00A1: return OP_SKNP;
+                    default: return OP_INVALID;
+                }
+            default:
+                switch(instruction & 0x00FF) {
+                    case 0x0000: return (instruction & 0x0F00) == 0 ? OP_LD_I_LONG : OP_INVALID;
+                    case 0x0001: return OP_PLANE;
+                    case 0x0002: return (instruction & 0x0F00) == 0 ? OP_AUDIO : OP_INVALID;
+                    case 0x0007: return OP_LD_VX_DT;
+                    case 0x000A: return OP_LD_VX_K;
+                    case 0x0015: return OP_LD_DT_VX;
+                    case 0x0018: return OP_LD_ST_VX;
+                    case 0x001E: return OP_ADD_I;
+                    case 0x0029: return OP_LD_F;
+                    case 0x0030: return OP_LD_HF;
+                    case 0x0033: return OP_LD_B;
+                    case 0x003A: return OP_PITCH;
+                    case 0x0055: return OP_LD_MEM_VX;
+                    case 0x0065: return OP_LD_VX_MEM;
+                    case 0x0075: return OP_LD_R_VX;
+                    case 0x0085: return OP_LD_VX_R;
+                    default: return OP_INVALID;
+                }
+        }
+    }
+
+    // a bit mask of opcode classes, for c8_breakpoints
+    inline uint64_t opcodeBit(c8_opcode_class op) {
+        return uint64_t(1) << op;
+    }
+
+    /**
+     * The RAM an instruction reads or writes through I, given the value of I and the selected XO-CHIP planes.
+     * Ranges are [start, end). Instruction fetches aren't included.
+     */
+    struct c8_memory_access {
+        uint32_t readStart = 0, readEnd = 0;
+        uint32_t writeStart = 0, writeEnd = 0;
+    };
+
+    inline c8_memory_access memoryAccessOf(uint16_t instruction, uint16_t I, uint8_t planes = 1) {
+        c8_memory_access access;
+        uint32_t x = (instruction & 0x0F00) >> 8, y = (instruction & 0x00F0) >> 4;
+        uint32_t range = (x < y ? y - x : x - y) + 1;
+        switch(classifyOpcode(instruction)) {
+            case OP_DRW:
+                access.readStart = I;
+                // Dxy0 is a 16x16 sprite, 32 bytes. Each plane drawn has its own sprite
+                access.readEnd = I + ((instruction & 0x000F) == 0 ? 32 : (instruction & 0x000F))
+                                     * ((planes & 1) + (planes >> 1 & 1));
+                break;
+            case OP_LD_VX_MEM:
+                access.readStart = I;
+                access.readEnd = I + x + 1;
+                break;
+            case OP_LD_B:
+                access.writeStart = I;
+                access.writeEnd = I + 3;
+                break;
+            case OP_LD_MEM_VX:
+                access.writeStart = I;
+                access.writeEnd = I + x + 1;
+                break;
+            case OP_LOAD_RANGE:
+                access.readStart = I;
+                access.readEnd = I + range;
+                break;
+            case OP_SAVE_RANGE:
+                access.writeStart = I;
+                access.writeEnd = I + range;
+                break;
+            case OP_AUDIO:
+                access.readStart = I;
+                access.readEnd = I + 16;
+                break;
+            default:
+                break;
+        }
+        return access;
+    }
+}
@@ -0,0 +1,121 @@
+#include "c8_paged_ram.hpp"
+#include "c8_hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace yac8 {
+    std::shared_ptr<c8_paged_ram::page> c8_paged_ram::intern(const uint8_t *bytes) {
+        static std::mutex mutex;
+        static std::unordered_map<uint64_t, std::weak_ptr<page>> pool;
+        // slots whose page died are swept out whenever the pool has doubled since the last sweep
+        static size_t sweepAt = 1024;
+
+        // most of the XO-CHIP address space is never touched by a program. Those pages are recognized without
+        // hashing them, and all share one page that lives forever
+        static const uint8_t zeroes[PAGE_SIZE] = {0};
+        static const std::shared_ptr<page> zero = [] {
+            std::shared_ptr<page> p = std::make_shared<page>();
+            p->interned = true;
+            return p;
+        }();
+        if(std::memcmp(bytes, zeroes, PAGE_SIZE) == 0)
+            return zero;
+
+        uint64_t hash = fnv1a(bytes, PAGE_SIZE);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(pool.size() >= sweepAt) {
+            for(auto it = pool.begin(); it != pool.end();) {
+                if(it->second.expired())
+                    it = pool.erase(it);
+                else
+                    ++it;
+            }
+            sweepAt = std::max<size_t>(1024, pool.size() * 2);
+        }
+
+        std::weak_ptr<page> &slot = pool[hash];
+        std::shared_ptr<page> existing = slot.lock();
+        if(existing) {
+            if(std::memcmp(existing->bytes, bytes, PAGE_SIZE) == 0)
+                return existing;
+            // hash collision, don't share
+            std::shared_ptr<page> p = std::make_shared<page>();
+            std::memcpy(p->bytes, bytes, PAGE_SIZE);
+            return p;
+        }
+        // allocated apart from its control block, which the pool's weak_ptr keeps alive after the page has died
+        std::shared_ptr<page> p(new page);
+        std::memcpy(p->bytes, bytes, PAGE_SIZE);
+        p->interned = true;
+        slot = p;
+        return p;
+    }
+
+    c8_paged_ram::c8_paged_ram() {
+        const uint8_t zeroes[PAGE_SIZE] = {0};
+        std::shared_ptr<page> zero = intern(zeroes);
+        std::fill(pages, pages + PAGE_COUNT, zero);
+    }
+
+    c8_paged_ram::c8_paged_ram(const uint8_t *ram) {
+        for(int p = 0; p < PAGE_COUNT; p++) {
+            pages[p] = intern(ram + p * PAGE_SIZE);
+        }
+    }
+
+    const uint8_t *c8_paged_ram::sprite(uint16_t addr, uint8_t n, uint8_t *scratch) const {
+        int offset = addr % PAGE_SIZE;
+        if(offset + n <= PAGE_SIZE)
+            return pages[addr / PAGE_SIZE]->bytes + offset;
+        for(int i = 0; i < n; i++) {
+            scratch[i] = read(static_cast<uint16_t>((addr + i) % RAM_SIZE));
+        }
+        return scratch;
+    }
+
+    void c8_paged_ram::store(uint8_t *ram) const {
+        for(int p = 0; p < PAGE_COUNT; p++) {
+            std::memcpy(ram + p * PAGE_SIZE, pages[p]->bytes, PAGE_SIZE);
+        }
+    }
+
+    void c8_paged_ram::storePage(uint8_t *ram, int p) const {
+        std::memcpy(ram + p * PAGE_SIZE, pages[p]->bytes, PAGE_SIZE);
+    }
+
+    int c8_paged_ram::sharedPages(const c8_paged_ram &other) const {
+        int shared = 0;
+        for(int p = 0; p < PAGE_COUNT; p++) {
+            if(pages[p] == other.pages[p])
+                shared++;
+        }
+        return shared;
+    }
+
+    c8_paged_state::c8_paged_state(const c8_state &state) : c8_registers(state), ram(state.ram) {
+    }
+
+    void c8_paged_state::store(c8_state &state) const {
+        static_cast<c8_registers &>(state) = *this;
+        ram.store(state.ram);
+        state.reloads++;
+    }
+
+    void c8_paged_state::storeWritten(c8_state &state, uint32_t pageWritesThen[PAGE_COUNT]) const {
+        static_cast<c8_registers &>(state) = *this;
+        for(int p = 0; p < PAGE_COUNT; p++) {
+            if(state.pageWrites[p] != pageWritesThen[p]) {
+                ram.storePage(state.ram, p);
+                pageWritesThen[p] = ++state.pageWrites[p];
+            }
+        }
+    }
+
+    bool c8_paged_state::step(c8_hardware_api &hardware_api, c8_quirks quirks) {
+        return execute(ram, hardware_api, quirks);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <memory>
+
+#include "c8_constants.hpp"
+#include "c8_state.hpp"
+
+namespace yac8 {
+    /**
+     * Chip-8 RAM split into reference-counted, copy-on-write pages. Copying a c8_paged_ram only copies page pointers; a
+     * shared or interned page is duplicated the first time it's written.
+     */
+    class c8_paged_ram {
+        struct page {
+            uint8_t bytes[PAGE_SIZE];
+            // pages in the intern pool can be handed to another c8_paged_ram, on any thread, at any time, so they're
+            // never written in place even when nothing else holds them
+            bool interned = false;
+        };
+        std::shared_ptr<page> pages[PAGE_COUNT];
+
+        static std::shared_ptr<page> intern(const uint8_t *bytes);
+    public:
+        c8_paged_ram();
+        // builds pages from a flat RAM image, sharing identical pages with every other c8_paged_ram still alive
+        explicit c8_paged_ram(const uint8_t *ram);
+
+        uint8_t read(uint16_t addr) const {
+            return pages[addr / PAGE_SIZE]->bytes[addr % PAGE_SIZE];
+        }
+        void write(uint16_t addr, uint8_t value) {
+            std::shared_ptr<page> &p = pages[addr / PAGE_SIZE];
+            if(p->interned || p.use_count() != 1) {
+                std::shared_ptr<page> copy = std::make_shared<page>();
+                std::memcpy(copy->bytes, p->bytes, PAGE_SIZE);
+                p = copy;
+            }
+            p->bytes[addr % PAGE_SIZE] = value;
+        }
+        // sprites may straddle a page boundary, so they are gathered into `scratch`
+        const uint8_t *sprite(uint16_t addr, uint8_t n, uint8_t *scratch) const;
+
+        // copies every page into a flat RAM image
+        void store(uint8_t *ram) const;
+        // copies page `p` alone into a flat RAM image
+        void storePage(uint8_t *ram, int p) const;
+        // number of pages physically shared with `other`
+        int sharedPages(const c8_paged_ram &other) const;
+    };
+
+    /**
+     * A c8_state whose RAM is paged, for workloads that fork states constantly (search, speculative execution).
+     * Copying one costs the registers plus PAGE_COUNT pointer copies, instead of all of RAM.
+     */
+    class c8_paged_state : public c8_registers {
+    public:
+        c8_paged_ram ram;
+
+        c8_paged_state() = default;
+        explicit c8_paged_state(const c8_state &state);
+        // writes registers and RAM back into a regular c8_state
+        void store(c8_state &state) const;
+        // like store(), into a state whose RAM already matches this one's apart from the pages written since
+        // `pageWritesThen` was taken from its pageWrites. Only those pages are copied, and their counts bumped, and
+        // `pageWritesThen` is brought up to date so that it can be passed again next time
+        void storeWritten(c8_state &state, uint32_t pageWritesThen[PAGE_COUNT]) const;
+        bool step(c8_hardware_api &window, c8_quirks quirks);
+    };
+}
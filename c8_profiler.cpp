@@ -0,0 +1,143 @@
+#include "c8_profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace yac8 {
+    c8_profiler::c8_profiler() {
+        callTree.push_back({0, -1, 0, 0});
+    }
+
+    void c8_profiler::reset() {
+        std::fill(executions, executions + RAM_SIZE, 0);
+        std::fill(takenBranches, takenBranches + RAM_SIZE, 0);
+        std::fill(opcodes, opcodes + RAM_SIZE, 0);
+        callEdges.clear();
+        totalExecutions = 0;
+        hottest = 0;
+
+        // rebuild the path the guest is currently on, so later returns still match up
+        std::vector<uint16_t> path;
+        for(int i = 1; i <= depth; i++) {
+            path.push_back(callTree[i < depth ? shadowStack[i] : currentNode].routine);
+        }
+        callTree.clear();
+        callTree.push_back({0, -1, 0, 0});
+        callChildren.clear();
+        depth = 0;
+        currentNode = 0;
+        for(uint16_t routine : path) {
+            enter(routine);
+            callTree[currentNode].calls = 0;
+        }
+    }
+
+    void c8_profiler::enter(uint16_t routine) {
+        if(depth == STACK_SIZE)
+            return;
+        uint64_t key = (uint64_t) currentNode << 16 | routine;
+        auto child = callChildren.find(key);
+        int32_t node;
+        if(child == callChildren.end()) {
+            node = (int32_t) callTree.size();
+            callTree.push_back({routine, currentNode, 0, 0});
+            callChildren.emplace(key, node);
+        } else {
+            node = child->second;
+        }
+        shadowStack[depth++] = currentNode;
+        currentNode = node;
+        callTree[node].calls++;
+    }
+
+    std::vector<uint64_t> c8_profiler::inclusiveCycles() const {
+        std::vector<uint64_t> inclusive(callTree.size());
+        for(size_t i = callTree.size(); i-- > 0;) {
+            inclusive[i] += callTree[i].exclusive;
+            if(callTree[i].parent >= 0)
+                inclusive[callTree[i].parent] += inclusive[i];
+        }
+        return inclusive;
+    }
+
+    bool c8_profiler::writeCollapsedStacks(const std::string &path) const {
+        std::ofstream os(path, std::ios::out | std::ios::trunc);
+        if(!os.is_open())
+            return false;
+        std::vector<std::string> names(callTree.size());
+        for(size_t i = 0; i < callTree.size(); i++) {
+            if(callTree[i].parent < 0) {
+                names[i] = "root";
+            } else {
+                std::ostringstream name;
+                name << names[callTree[i].parent] << ";sub_" << std::hex << std::setfill('0') << std::setw(3)
+                     << callTree[i].routine;
+                names[i] = name.str();
+            }
+            if(callTree[i].exclusive != 0)
+                os << names[i] << " " << callTree[i].exclusive << "\n";
+        }
+        return true;
+    }
+
+    // instructions after which execution never falls through
+    static bool endsBlock(uint16_t opcode) {
+        switch(opcode & 0xF000) {
+            case 0x1000:
+            case 0x2000:
+            case 0xB000:
+                return true;
+            case 0x0000:
+                return opcode == 0x00EE;
+            default:
+                return false;
+        }
+    }
+
+    std::vector<c8_profiler::block> c8_profiler::hotBlocks(size_t count) const {
+        std::vector<block> blocks;
+        bool open = false;
+        for(int addr = 0; addr < RAM_SIZE; addr++) {
+            if(executions[addr] == 0)
+                continue;
+            if(open && blocks.back().end + 2 == addr) {
+                blocks.back().end = addr;
+                blocks.back().executions += executions[addr];
+            } else {
+                blocks.push_back({(uint16_t) addr, (uint16_t) addr, executions[addr]});
+            }
+            open = !endsBlock(opcodes[addr]);
+        }
+
+        count = std::min(count, blocks.size());
+        std::partial_sort(blocks.begin(), blocks.begin() + count, blocks.end(),
+                          [](const block &a, const block &b) { return a.executions > b.executions; });
+        blocks.resize(count);
+        return blocks;
+    }
+
+    bool c8_profiler::writeCSV(const std::string &path) const {
+        std::ofstream os(path, std::ios::out | std::ios::trunc);
+        if(!os.is_open())
+            return false;
+        os << "kind,from,to,opcode,count\n" << std::hex << std::setfill('0');
+        for(int addr = 0; addr < RAM_SIZE; addr++) {
+            if(executions[addr] != 0) {
+                os << "exec,0x" << std::setw(3) << addr << ",,0x" << std::setw(4) << opcodes[addr]
+                   << "," << std::dec << executions[addr] << std::hex << "\n";
+            }
+            if(takenBranches[addr] != 0) {
+                os << "branch,0x" << std::setw(3) << addr << ",,0x" << std::setw(4) << opcodes[addr]
+                   << "," << std::dec << takenBranches[addr] << std::hex << "\n";
+            }
+        }
+        for(const auto &edge : callEdges) {
+            uint16_t from = edge.first >> 16, to = edge.first & 0xFFFF;
+            os << "call,0x" << std::setw(3) << from << ",0x" << std::setw(3) << to << ",0x" << std::setw(4)
+               << opcodes[from] << "," << std::dec << edge.second << std::hex << "\n";
+        }
+        return true;
+    }
+}
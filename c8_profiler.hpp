@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "c8_constants.hpp"
+
+namespace yac8 {
+    /**
+     * Counts where guest code spends its cycles: executions and taken branches per address, CALL edges, and a call
+     * tree built from a shadow of the guest's call stack.
+     * Updated by c8_machine when attached, so it costs nothing when it isn't.
+     */
+    class c8_profiler {
+        // the call tree path to where the guest is now; callTree indices
+        int32_t shadowStack[STACK_SIZE];
+        int depth = 0;
+        int32_t currentNode = 0;
+        // (parent node << 16 | routine) -> child node
+        std::unordered_map<uint64_t, int32_t> callChildren;
+
+        void enter(uint16_t routine);
+        void leave() {
+            if(depth > 0)
+                currentNode = shadowStack[--depth];
+        }
+    public:
+        uint64_t executions[RAM_SIZE] = {0};
+        // jumps, calls, returns, and skips that skipped
+        uint64_t takenBranches[RAM_SIZE] = {0};
+        // the last opcode executed at each address
+        uint16_t opcodes[RAM_SIZE] = {0};
+        // (caller address << 16 | callee address) -> number of calls
+        std::unordered_map<uint32_t, uint64_t> callEdges;
+        uint64_t totalExecutions = 0;
+        // the highest count in `executions`, kept up as they're counted
+        uint64_t hottest = 0;
+
+        /**
+         * A routine, as reached through one particular chain of calls. Node 0 is the root, i.e. code outside any call.
+         */
+        struct call_node {
+            uint16_t routine;
+            int32_t parent;
+            // cycles spent in this routine itself, not counting the routines it called
+            uint64_t exclusive;
+            uint64_t calls;
+        };
+        // parents always come before their children
+        std::vector<call_node> callTree;
+
+        /**
+         * A run of consecutively executed instructions, ending at a jump, call or return.
+         */
+        struct block {
+            uint16_t start, end; // [start, end]
+            uint64_t executions;
+        };
+
+        c8_profiler();
+
+        void record(uint16_t pc, uint16_t opcode, uint16_t nextPc) {
+            if(++executions[pc] > hottest)
+                hottest = executions[pc];
+            opcodes[pc] = opcode;
+            totalExecutions++;
+            callTree[currentNode].exclusive++;
+            switch(opcode >> 12) {
+                case 0x0:
+                    if(opcode == 0x00EE) {
+                        takenBranches[pc]++;
+                        leave();
+                    }
+                    break;
+                case 0x2:
+                    // a call that overflowed the stack falls through to the next instruction instead
+                    if(nextPc == (opcode & 0x0FFF)) {
+                        callEdges[(uint32_t) pc << 16 | nextPc]++;
+                        takenBranches[pc]++;
+                        enter(nextPc);
+                    }
+                    break;
+                case 0x1:
+                case 0xB:
+                    takenBranches[pc]++;
+                    break;
+                case 0x3:
+                case 0x4:
+                case 0x5:
+                case 0x9:
+                case 0xE:
+                    // a skip over a 4 byte F000 NNNN moves 6 bytes
+                    if(nextPc != pc + 2)
+                        takenBranches[pc]++;
+                    break;
+            }
+        }
+
+        // zeroes every count. The call tree keeps the path to where the guest is now
+        void reset();
+        // the `count` blocks with the most executed instructions, hottest first
+        std::vector<block> hotBlocks(size_t count) const;
+        // writes "kind,from,to,opcode,count" rows: kind is exec, branch or call
+        bool writeCSV(const std::string &path) const;
+
+        // cycles spent in each call tree node including everything it called, indexed like callTree
+        std::vector<uint64_t> inclusiveCycles() const;
+        // writes "root;sub_2a4;sub_31c <cycles>" lines of exclusive cycles, the input format of flame graph tools
+        bool writeCollapsedStacks(const std::string &path) const;
+    };
+}
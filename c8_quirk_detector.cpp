@@ -0,0 +1,92 @@
+#include "c8_quirk_detector.hpp"
+#include "c8_hash.hpp"
+#include "c8_input_script.hpp"
+#include "c8_machine.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <thread>
+#include <unordered_set>
+
+namespace yac8 {
+    // past this many distinct frames the ROM is clearly animating, and more says nothing about the quirks
+    const int MAX_DISTINCT_FRAMES = 16;
+
+    static void runTrial(const c8_machine &booted, int processorSpeed, int guestSeconds, uint32_t seed,
+                         c8_quirk_trial &trial) {
+        // fork the booted machine
+        c8_machine machine;
+        machine.state = booted.state;
+        machine.display = booted.display;
+        machine.quirks = trial.quirks;
+        machine.processorSpeed = processorSpeed;
+
+        // the input script only depends on the seed, so every trial sees the same key presses
+        c8_input_script script(seed);
+
+        const int cyclesPerFrame = std::max(1, processorSpeed / TIMER_FREQUENCY);
+        std::unordered_set<uint64_t> frames;
+        for(int frame = 0; frame < guestSeconds * TIMER_FREQUENCY; frame++) {
+            script.frame(machine);
+
+            for(int i = 0; i < cyclesPerFrame; i++) {
+                if(!machine.step())
+                    trial.invalidInstructions++;
+            }
+            trial.faults |= machine.state.faults;
+
+            const c8_display &display = machine.display;
+            long lit = 0;
+            for(int y = 0; y < display.height(); y++) {
+                for(int w = 0; w < display.width() / 64; w++) {
+                    lit += std::bitset<64>(display.rows[0][y][w] | display.rows[1][y][w]).count();
+                }
+            }
+            if(lit == 0 || lit == display.width() * display.height())
+                trial.degenerateFrames++;
+            if(frames.size() < MAX_DISTINCT_FRAMES)
+                frames.insert(display.hash());
+        }
+        trial.distinctFrames = static_cast<int>(frames.size());
+
+        int faultCount = 0;
+        for(uint8_t f = trial.faults; f != 0; f &= f - 1) {
+            faultCount++;
+        }
+        const int totalFrames = guestSeconds * TIMER_FREQUENCY;
+        trial.score = -100000L * faultCount
+                      - 1000L * std::min(trial.invalidInstructions, 100)
+                      - 1000L * trial.degenerateFrames / totalFrames
+                      + trial.distinctFrames;
+    }
+
+    std::vector<c8_quirk_trial> runQuirkTrials(const uint8_t *rom, int size, int processorSpeed,
+                                               int guestSeconds, uint32_t seed) {
+        c8_machine booted;
+        booted.reset(rom, size, seed);
+
+        // the default quirks come first, so they win any tie
+        std::vector<c8_quirk_trial> trials(8);
+        for(int i = 0; i < 8; i++) {
+            trials[i].quirks = unpackQuirks(static_cast<uint16_t>(7 - i));
+        }
+
+        std::vector<std::thread> workers;
+        for(c8_quirk_trial &trial : trials) {
+            workers.emplace_back([&booted, &trial, processorSpeed, guestSeconds, seed]() {
+                runTrial(booted, processorSpeed, guestSeconds, seed, trial);
+            });
+        }
+        for(std::thread &worker : workers) {
+            worker.join();
+        }
+
+        std::stable_sort(trials.begin(), trials.end(),
+                         [](const c8_quirk_trial &a, const c8_quirk_trial &b) { return a.score > b.score; });
+        return trials;
+    }
+
+    c8_quirks detectQuirks(const uint8_t *rom, int size, int processorSpeed) {
+        return runQuirkTrials(rom, size, processorSpeed).front().quirks;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "c8_quirks.hpp"
+
+namespace yac8 {
+    /**
+     * How a ROM behaved when run headlessly under one combination of quirks.
+     */
+    struct c8_quirk_trial {
+        c8_quirks quirks{};
+        // instructions the core didn't recognise
+        int invalidInstructions = 0;
+        // c8_fault flags raised during the run
+        uint8_t faults = 0;
+        // frames that were entirely blank or entirely lit
+        int degenerateFrames = 0;
+        // number of distinct framebuffers seen, capped to keep the score bounded
+        int distinctFrames = 0;
+        long score = 0;
+    };
+
+    /**
+     * Speculatively runs a ROM under every combination of quirks, in parallel, with the same scripted random input.
+     * Each trial forks the same freshly booted machine and runs for `guestSeconds` of guest time.
+     * Trials are returned best first; a trial's score penalises faults, invalid instructions and degenerate output.
+     */
+    std::vector<c8_quirk_trial> runQuirkTrials(const uint8_t *rom, int size, int processorSpeed,
+                                               int guestSeconds = 10, uint32_t seed = 0xC8);
+
+    // the quirks of the best trial
+    c8_quirks detectQuirks(const uint8_t *rom, int size, int processorSpeed);
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 namespace yac8 {
     /**
      * A struct for specifying emulation "quirks" that certain games expect.
@@ -9,4 +11,17 @@ namespace yac8 {
         bool shiftQuirk = true;
         bool wrap = true;
     };
-}
\ No newline at end of file
+
+    // quirks as a bitfield, for movies and the ROM library index
+    inline uint16_t packQuirks(const c8_quirks &quirks) {
+        return (quirks.loadStoreQuirk ? 1 : 0) | (quirks.shiftQuirk ? 2 : 0) | (quirks.wrap ? 4 : 0);
+    }
+
+    inline c8_quirks unpackQuirks(uint16_t packed) {
+        c8_quirks quirks{};
+        quirks.loadStoreQuirk = (packed & 1) != 0;
+        quirks.shiftQuirk = (packed & 2) != 0;
+        quirks.wrap = (packed & 4) != 0;
+        return quirks;
+    }
+}
@@ -0,0 +1,102 @@
+#include "c8_rewind.hpp"
+
+#include <algorithm>
+
+namespace yac8 {
+    c8_rewind::c8_rewind(uint64_t interval, size_t capacity) : interval(interval), capacity(capacity) {}
+
+    void c8_rewind::clear() {
+        snapshots.clear();
+        events.clear();
+        nextSnapshot = 0;
+    }
+
+    void c8_rewind::snapshot(const c8_machine &machine) {
+        if(snapshots.size() >= capacity) {
+            snapshots.pop_front();
+            while(!events.empty() && events.front().cycle < snapshots.front().cycle) {
+                events.pop_front();
+            }
+        }
+        snapshots.emplace_back();
+        machine.save(snapshots.back());
+        nextSnapshot = machine.cycle + interval;
+    }
+
+    size_t c8_rewind::latestSnapshotBefore(uint64_t cycle) const {
+        auto it = std::upper_bound(snapshots.begin(), snapshots.end(), cycle,
+                                   [](uint64_t c, const c8_machine_snapshot &s) { return c < s.cycle; });
+        return (size_t) (it - snapshots.begin()) - 1;
+    }
+
+    void c8_rewind::replay(c8_machine &machine, size_t index, uint64_t cycle) const {
+        machine.restore(snapshots[index]);
+        auto event = std::lower_bound(events.begin(), events.end(), machine.cycle,
+                                      [](const c8_movie_event &e, uint64_t c) { return e.cycle < c; });
+        while(true) {
+            while(event != events.end() && event->cycle == machine.cycle) {
+                applyMovieEvent(machine, *event++);
+            }
+            if(machine.cycle >= cycle)
+                break;
+            machine.advance();
+        }
+    }
+
+    bool c8_rewind::canSeek(uint64_t cycle) const {
+        return !snapshots.empty() && cycle >= snapshots.front().cycle;
+    }
+
+    bool c8_rewind::seek(c8_machine &machine, uint64_t cycle) {
+        if(!canSeek(cycle) || cycle > machine.cycle)
+            return false;
+        size_t index = latestSnapshotBefore(cycle);
+        replay(machine, index, cycle);
+
+        // the future that was undone is gone; running forward again makes a new one
+        snapshots.erase(snapshots.begin() + index + 1, snapshots.end());
+        while(!events.empty() && events.back().cycle > cycle) {
+            events.pop_back();
+        }
+        nextSnapshot = snapshots.back().cycle + interval;
+        return true;
+    }
+
+    bool c8_rewind::seekBreakpoint(c8_machine &machine, c8_breakpoints breakpoints) {
+        uint64_t now = machine.cycle;
+        if(!canSeek(now) || now == snapshots.front().cycle)
+            return false;
+        breakpoints.breakOnNext(0);
+        if(!breakpoints.armed())
+            return false;
+
+        // search one snapshot interval at a time, latest first, for the last cycle the breakpoints hit on
+        for(size_t index = latestSnapshotBefore(now - 1) + 1; index-- > 0;) {
+            uint64_t end = index + 1 < snapshots.size() ? std::min(snapshots[index + 1].cycle, now) : now;
+            machine.restore(snapshots[index]);
+            // conditions only break on becoming true, so they start from the restored state rather than from
+            // wherever the previous, later interval left them
+            breakpoints.prime(machine.state);
+            auto event = std::lower_bound(events.begin(), events.end(), machine.cycle,
+                                          [](const c8_movie_event &e, uint64_t c) { return e.cycle < c; });
+            uint64_t hit = 0;
+            bool found = false;
+            while(machine.cycle < end) {
+                while(event != events.end() && event->cycle == machine.cycle) {
+                    applyMovieEvent(machine, *event++);
+                }
+                machine.advance();
+                if(machine.cycle < now && breakpoints.check(machine.state)) {
+                    hit = machine.cycle;
+                    found = true;
+                }
+            }
+            if(found)
+                return seek(machine, hit);
+        }
+
+        // nothing in the history hit, so put the machine back where it was
+        replay(machine, latestSnapshotBefore(now), now);
+        return false;
+    }
+}
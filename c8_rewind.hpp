@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+
+#include "c8_breakpoints.hpp"
+#include "c8_machine.hpp"
+#include "c8_movie.hpp"
+
+namespace yac8 {
+    /**
+     * Lets the debugger run a c8_machine backwards. A snapshot is taken every `interval` cycles into a bounded ring,
+     * and every outside event is kept alongside; going back to any cycle restores the nearest snapshot before it and
+     * deterministically re-executes up to it, so the cost of a reverse step is bounded by `interval` cycles no matter
+     * how long the session has been running.
+     */
+    class c8_rewind {
+        std::deque<c8_machine_snapshot> snapshots;
+        // events since the oldest snapshot, in the order they were applied
+        std::deque<c8_movie_event> events;
+        uint64_t nextSnapshot = 0;
+
+        void snapshot(const c8_machine &machine);
+        // restores snapshots[index], then re-executes up to `cycle`, including the events applied at `cycle`
+        void replay(c8_machine &machine, size_t index, uint64_t cycle) const;
+        size_t latestSnapshotBefore(uint64_t cycle) const;
+    public:
+        uint64_t interval;
+        size_t capacity;
+
+        explicit c8_rewind(uint64_t interval = 5000, size_t capacity = 2048);
+        // forgets all history, e.g. after a reset
+        void clear();
+
+        // call before applying events and stepping, once per emulation loop
+        void capture(const c8_machine &machine) {
+            if(machine.cycle >= nextSnapshot)
+                snapshot(machine);
+        }
+        // call for every event applied to the machine
+        void record(const c8_movie_event &event) {
+            if(!snapshots.empty())
+                events.push_back(event);
+        }
+
+        // true if `cycle` is still within the recorded history
+        bool canSeek(uint64_t cycle) const;
+        // puts the machine back the way it was at `cycle`, and forgets everything after it
+        bool seek(c8_machine &machine, uint64_t cycle);
+        // seeks to the latest earlier cycle at which `breakpoints` would have stopped execution.
+        // One-shot "break on next" breakpoints only apply going forwards, and are ignored
+        bool seekBreakpoint(c8_machine &machine, c8_breakpoints breakpoints);
+    };
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+namespace yac8 {
+    /**
+     * A lock-free single-producer/single-consumer ring buffer. `Capacity` must be a power of two.
+     * Neither side ever blocks: push() fails when full, pop() fails when empty.
+     */
+    template<class T, size_t Capacity>
+    class c8_ring_buffer {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        T items[Capacity];
+        // kept on separate cache lines so producer and consumer don't false-share. Each side also keeps a stale copy
+        // of the other side's index, and only re-reads the shared one when the stale copy says full/empty
+        alignas(64) std::atomic<size_t> head{0}; // next slot to pop, owned by the consumer
+        size_t cachedTail = 0;
+        alignas(64) std::atomic<size_t> tail{0}; // next slot to push, owned by the producer
+        size_t cachedHead = 0;
+        alignas(64) char padding[1] = {0};
+    public:
+        bool push(const T &item) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if(t - cachedHead == Capacity) {
+                cachedHead = head.load(std::memory_order_acquire);
+                if(t - cachedHead == Capacity)
+                    return false;
+            }
+            items[t & (Capacity - 1)] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T &item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h == cachedTail) {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if(h == cachedTail)
+                    return false;
+            }
+            item = items[h & (Capacity - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+        size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+    };
+}
@@ -0,0 +1,155 @@
+#include "c8_rom_library.hpp"
+#include "c8_constants.hpp"
+#include "c8_hash.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace yac8 {
+    // ROMs that are known to need something other than the default quirks, see README.md
+    static const struct {
+        uint64_t hash;
+        const char *title;
+        bool loadStoreQuirk, shiftQuirk, wrap;
+    } BUILTIN_PROFILES[] = {
+        {0x56049e83866b207dULL, "TICTAC", true, true, true},
+        {0x8e547ebb12c026b4ULL, "INVADERS", true, true, true},
+        {0x29bcab9b664d212bULL, "BLITZ", true, true, false},
+    };
+
+    static bool readROM(const std::string &path, c8_rom &rom) {
+        std::ifstream is(path, std::ios::in | std::ios::binary);
+        if(!is.is_open())
+            return false;
+        std::shared_ptr<std::vector<char>> data = std::make_shared<std::vector<char>>(
+                (std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        if(data->empty() || data->size() > RAM_SIZE - PROGRAM_OFFSET)
+            return false;
+
+        rom.path = path;
+        rom.title = std::filesystem::path(path).filename().string();
+        rom.hash = fnv1a(data->data(), data->size());
+        rom.data = data;
+        return true;
+    }
+
+    c8_rom_library::c8_rom_library(std::string indexPath) : indexPath(std::move(indexPath)) {
+        for(const auto &builtin : BUILTIN_PROFILES) {
+            index_entry &entry = index[builtin.hash];
+            entry.title = builtin.title;
+            entry.profile.quirks.loadStoreQuirk = builtin.loadStoreQuirk;
+            entry.profile.quirks.shiftQuirk = builtin.shiftQuirk;
+            entry.profile.quirks.wrap = builtin.wrap;
+        }
+    }
+
+    c8_rom_library::~c8_rom_library() {
+        if(scanner.joinable())
+            scanner.join();
+    }
+
+    void c8_rom_library::scan(const std::string &directory) {
+        if(scanning)
+            return;
+        if(scanner.joinable())
+            scanner.join();
+
+        scanning = true;
+        scanner = std::thread([this, directory]() {
+            loadIndex();
+
+            std::error_code error;
+            for(const auto &file : std::filesystem::directory_iterator(directory, error)) {
+                c8_rom rom;
+                if(!file.is_regular_file() || !readROM(file.path().string(), rom))
+                    continue;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                attachProfile(rom);
+                auto existing = std::find_if(roms.begin(), roms.end(), [&](const c8_rom &r) { return r.path == rom.path; });
+                if(existing != roms.end()) {
+                    *existing = rom;
+                } else {
+                    roms.insert(std::upper_bound(roms.begin(), roms.end(), rom,
+                            [](const c8_rom &a, const c8_rom &b) { return a.title < b.title; }), rom);
+                }
+            }
+            scanning = false;
+        });
+    }
+
+    std::vector<c8_rom> c8_rom_library::list() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return roms;
+    }
+
+    std::future<c8_rom> c8_rom_library::load(const std::string &path) const {
+        return std::async(std::launch::async, [this, path]() {
+            c8_rom rom;
+            if(readROM(path, rom)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                attachProfile(rom);
+            }
+            return rom;
+        });
+    }
+
+    void c8_rom_library::setProfile(const c8_rom &rom, const c8_rom_profile &profile) {
+        std::lock_guard<std::mutex> lock(mutex);
+        index_entry &entry = index[rom.hash];
+        entry.title = rom.title;
+        entry.profile = profile;
+        for(c8_rom &r : roms) {
+            if(r.hash == rom.hash)
+                attachProfile(r);
+        }
+        saveIndex();
+    }
+
+    // expects the mutex to be held
+    void c8_rom_library::attachProfile(c8_rom &rom) const {
+        auto entry = index.find(rom.hash);
+        rom.hasProfile = entry != index.end();
+        if(rom.hasProfile)
+            rom.profile = entry->second.profile;
+    }
+
+    // index format: one ROM per line, "<hash> <quirks> <processor speed> <title>", '#' starts a comment. The file
+    // can be edited by hand, so lines that don't parse are skipped and values are brought into range
+    void c8_rom_library::loadIndex() {
+        std::ifstream is(indexPath);
+        std::string line;
+        while(std::getline(is, line)) {
+            if(line.empty() || line[0] == '#')
+                continue;
+            std::istringstream fields(line);
+            uint64_t hash;
+            uint16_t quirks;
+            index_entry entry;
+            if(!(fields >> std::hex >> hash >> quirks >> std::dec >> entry.profile.processorSpeed))
+                continue;
+            std::getline(fields >> std::ws, entry.title);
+            // only the bits packQuirks() writes, and a speed the emulator can run at (0 would divide by zero)
+            entry.profile.quirks = unpackQuirks(quirks & 7);
+            entry.profile.processorSpeed = std::clamp(entry.profile.processorSpeed, MIN_SPEED, MAX_SPEED);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            index[hash] = entry;
+        }
+    }
+
+    // expects the mutex to be held
+    void c8_rom_library::saveIndex() const {
+        std::ofstream os(indexPath, std::ios::out | std::ios::trunc);
+        os << "# yac8 ROM library: <content hash> <quirks> <processor speed> <title>\n";
+        for(const auto &entry : index) {
+            os << std::hex << std::setfill('0') << std::setw(16) << entry.first << " "
+               << packQuirks(entry.second.profile.quirks) << " "
+               << std::dec << entry.second.profile.processorSpeed << " "
+               << entry.second.title << "\n";
+        }
+    }
+}
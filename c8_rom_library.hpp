@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "c8_quirks.hpp"
+
+namespace yac8 {
+    /**
+     * The emulation settings a particular ROM expects.
+     */
+    struct c8_rom_profile {
+        c8_quirks quirks{};
+        int processorSpeed = 1000;
+    };
+
+    /**
+     * A ROM image, identified by the hash of its contents.
+     */
+    struct c8_rom {
+        std::string title;
+        std::string path;
+        uint64_t hash = 0;
+        std::shared_ptr<const std::vector<char>> data;
+        bool hasProfile = false;
+        c8_rom_profile profile{};
+    };
+
+    /**
+     * Scans a directory of ROMs on a background thread, keeping every ROM's contents in memory so that switching
+     * between them is instant. Quirk profiles are kept in an on-disk index, keyed by content hash.
+     */
+    class c8_rom_library {
+        struct index_entry {
+            std::string title;
+            c8_rom_profile profile;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<c8_rom> roms;
+        std::unordered_map<uint64_t, index_entry> index;
+        std::string indexPath;
+        std::thread scanner;
+        std::atomic<bool> scanning{false};
+
+        void loadIndex();
+        void saveIndex() const;
+        void attachProfile(c8_rom &rom) const;
+    public:
+        explicit c8_rom_library(std::string indexPath = "yac8_library.txt");
+        ~c8_rom_library();
+
+        // starts indexing every file in `directory` in the background
+        void scan(const std::string &directory);
+        bool isScanning() const { return scanning; }
+        // the ROMs scanned so far, sorted by title
+        std::vector<c8_rom> list() const;
+
+        // reads and hashes a ROM file off the calling thread, and attaches its profile if it has one
+        std::future<c8_rom> load(const std::string &path) const;
+
+        // remembers `profile` for this ROM, and writes the index to disk
+        void setProfile(const c8_rom &rom, const c8_rom_profile &profile);
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace yac8 {
+    /**
+     * Publishes a value from one writer thread to any number of readers without ever blocking the writer.
+     * Readers retry until they get a copy that no write overlapped, so they never see a torn value.
+     */
+    template<class T>
+    class c8_seqlock {
+        static_assert(std::is_trivially_copyable<T>::value, "c8_seqlock values are copied byte-wise");
+
+        // odd while a write is in progress
+        std::atomic<uint32_t> sequence{0};
+        T value{};
+    public:
+        void publish(const T &v) {
+            uint32_t s = sequence.load(std::memory_order_relaxed);
+            sequence.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(&value, &v, sizeof(T));
+            sequence.store(s + 2, std::memory_order_release);
+        }
+
+        T read() const {
+            T copy;
+            uint32_t before, after;
+            do {
+                before = sequence.load(std::memory_order_acquire);
+                std::memcpy(&copy, &value, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while(before != after || (before & 1) != 0);
+            return copy;
+        }
+    };
+}
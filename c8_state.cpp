@@ -1,4 +1,5 @@
 #include "c8_state.hpp"
+#include "c8_paged_ram.hpp"
 
 #include <thread>
 #include <random>
@@ -18,24 +19,32 @@ namespace yac8 {
         assert(PROGRAM_OFFSET+size < RAM_SIZE);
         // load ROM at program start (0x200)
         std::copy(rom, rom + size, ram + PROGRAM_OFFSET);
+        reloads++;
     }
 
-    void c8_state::loadTypography(const uint16_t *typography) {
+    void c8_state::loadTypography(const uint16_t *typography, const uint16_t *bigTypography) {
         // copy typography buffer (16 characters * 5 bytes per character)
         std::copy(typography, typography + 16 * 5, ram);
+        // and the SUPER-CHIP one right after it (16 characters * 10 bytes per character)
+        std::copy(bigTypography, bigTypography + 16 * 10, ram + BIG_TYPOGRAPHY_OFFSET);
     }
 
     // returns false iff the instruction at PC is invalid
     bool c8_state::step(c8_hardware_api &hardware_api, c8_quirks quirks) {
-        assert(pc >= PROGRAM_OFFSET);
-        assert(pc < RAM_SIZE);
-        assert(I >= 0);
-        assert(I < RAM_SIZE);
-        assert(sp >= 0);
-        assert(sp <= STACK_SIZE);
+        return execute(*this, hardware_api, quirks);
+    }
+
+    // shared by every RAM representation, so that flat and paged states execute identically
+    template<class Memory>
+    bool c8_registers::execute(Memory &memory, c8_hardware_api &hardware_api, c8_quirks quirks) {
+        // refuse to run anything outside of program memory; the machine stays put until reset
+        if(pc < PROGRAM_OFFSET || pc > RAM_SIZE - 2) {
+            faults |= FAULT_PC_OUT_OF_RANGE;
+            return false;
+        }
 
         // process instructions
-        uint16_t instruction = (uint16_t)(ram[pc] << 8) | (uint16_t)(ram[pc+1]);
+        uint16_t instruction = (uint16_t)(memory.read(pc) << 8) | (uint16_t)(memory.read(pc+1));
 
         // convenient aliases, used by A = {3,4,5,6,7,8,9,C,D,E}
         uint8_t x = static_cast<uint8_t>((instruction & 0x0F00) >> 8), y = static_cast<uint8_t>((instruction & 0x00F0) >> 4);
@@ -45,17 +54,62 @@ namespace yac8 {
         uint8_t byte = instruction & 0x00FF;
         uint8_t nibble = instruction & 0x000F;
 
+        // skips the next instruction, which is XO-CHIP's 4-byte F000 nnnn or 2 bytes like any other
+        auto skip = [&]() {
+            pc += pc + 3 < RAM_SIZE && memory.read(pc + 2) == 0xF0 && memory.read(pc + 3) == 0x00 ? 6 : 4;
+        };
+
         switch(instruction & 0xF000) {
             case 0x0000:
+                if((instruction & 0x00F0) == 0x00C0) {
+                    // 00Cn - SCD nibble (SUPER-CHIP)
+                    hardware_api.scroll_screen(0, nibble, planes);
+                    pc += 2;
+                    break;
+                }
+                if((instruction & 0x00F0) == 0x00D0) {
+                    // 00Dn - SCU nibble (XO-CHIP)
+                    hardware_api.scroll_screen(0, -nibble, planes);
+                    pc += 2;
+                    break;
+                }
                 switch(instruction & 0x00FF) {
                     case 0x00E0:
-                        hardware_api.clear_screen();
+                        hardware_api.clear_screen(planes);
                         pc += 2;
                         break;
                     case 0x00EE:
+                        if(sp == 0) {
+                            faults |= FAULT_STACK_UNDERFLOW;
+                            pc += 2;
+                            return false;
+                        }
                         pc = stack[--sp];
                         pc += 2;
                         break;
+                    case 0x00FB:
+                        // 00FB - SCR (SUPER-CHIP), scroll right by 4 pixels
+                        hardware_api.scroll_screen(4, 0, planes);
+                        pc += 2;
+                        break;
+                    case 0x00FC:
+                        // 00FC - SCL (SUPER-CHIP), scroll left by 4 pixels
+                        hardware_api.scroll_screen(-4, 0, planes);
+                        pc += 2;
+                        break;
+                    case 0x00FD:
+                        // 00FD - EXIT (SUPER-CHIP). There is nothing to exit to, so stay here until reset
+                        break;
+                    case 0x00FE:
+                        // 00FE - LOW (SUPER-CHIP), 64x32
+                        hardware_api.set_resolution(false);
+                        pc += 2;
+                        break;
+                    case 0x00FF:
+                        // 00FF - HIGH (SUPER-CHIP), 128x64
+                        hardware_api.set_resolution(true);
+                        pc += 2;
+                        break;
                     default:
                         pc += 2;
                         return false;
@@ -65,13 +119,18 @@ namespace yac8 {
                 pc = addr;
                 break;
             case 0x2000:
+                if(sp == STACK_SIZE) {
+                    faults |= FAULT_STACK_OVERFLOW;
+                    pc += 2;
+                    return false;
+                }
                 stack[sp++] = pc;
                 pc = addr;
                 break;
             case 0x3000:
                 // 3xkk - SE Vx, byte
                 if(vx == byte) {
-                    pc += 4;
+                    skip();
                 } else {
                     pc += 2;
                 }
@@ -79,19 +138,39 @@ namespace yac8 {
             case 0x4000:
                 // 4xkk - SNE Vx, byte
                 if(vx != byte) {
-                    pc += 4;
+                    skip();
                 } else {
                     pc += 2;
                 }
                 break;
-            case 0x5000:
-                // Axy0 - SE Vx, Vy
+            case 0x5000: {
+                if(nibble == 0x2 || nibble == 0x3) {
+                    // 5xy2 - LD [I], Vx-Vy and 5xy3 - LD Vx-Vy, [I] (XO-CHIP)
+                    // Store or read the registers from Vx to Vy, in either direction, at I. I is left alone.
+                    int count = (x < y ? y - x : x - y) + 1;
+                    int step = x < y ? 1 : -1;
+                    if(I + count > RAM_SIZE) {
+                        faults |= FAULT_I_OUT_OF_RANGE;
+                        pc += 2;
+                        return false;
+                    }
+                    for(int i = 0; i < count; i++) {
+                        if(nibble == 0x2)
+                            memory.write(I + i, v[x + i * step]);
+                        else
+                            v[x + i * step] = memory.read(I + i);
+                    }
+                    pc += 2;
+                    break;
+                }
+                // 5xy0 - SE Vx, Vy
                 if(vx == vy) {
-                    pc += 4;
+                    skip();
                 } else {
                     pc += 2;
                 }
                 break;
+            }
             case 0x6000:
                 // 6xkk - LD Vx, byte
                 vx = byte;
@@ -171,7 +250,7 @@ namespace yac8 {
             case 0x9000:
                 // 9xy0 - SNE Vx, Vy
                 if(vx != vy) {
-                    pc += 4;
+                    skip();
                 } else {
                     pc += 2;
                 }
@@ -190,26 +269,36 @@ namespace yac8 {
                 vx = byte & hardware_api.random_byte();
                 pc += 2;
                 break;
-            case 0xD000:
+            case 0xD000: {
                 // Dxyn - DRW Vx, Vy, nibble
                 // Display n-byte sprite starting at memory location I at (Vx, Vy), set VF = collision.
-                hardware_api.draw_sprite(ram + I, vx, vy, nibble, v[0xf]);
+                // Dxy0 is the SUPER-CHIP 16x16 sprite, two bytes per row. Each XO-CHIP plane drawn takes its own
+                // sprite, one after the other
+                uint8_t size = (nibble == 0 ? 32 : nibble) * ((planes & 1) + (planes >> 1 & 1));
+                if(I + size > RAM_SIZE) {
+                    faults |= FAULT_I_OUT_OF_RANGE;
+                    pc += 2;
+                    return false;
+                }
+                uint8_t scratch[0x40];
+                hardware_api.draw_sprite(memory.sprite(I, size, scratch), vx, vy, nibble, planes, v[0xf]);
                 pc += 2;
                 break;
+            }
             case 0xE000:
                 switch(instruction & 0x00FF) {
                     case 0x009E:
-                        // Ex9E - SKP Vx
-                        if(keyStates[vx]) {
-                            pc += 4;
+                        // Ex9E - SKP Vx. Only the low nibble of Vx names a key, as on the VIP
+                        if(keyStates[vx & 0xF]) {
+                            skip();
                         } else {
                             pc += 2;
                         }
                         break;
                     case 0x00A1:
                         // ExA1 - SKNP Vx
-                        if(!keyStates[vx]) {
-                            pc += 4;
+                        if(!keyStates[vx & 0xF]) {
+                            skip();
                         } else {
                             pc += 2;
                         }
@@ -221,6 +310,42 @@ namespace yac8 {
                 break;
             case 0xF000:
                 switch(instruction & 0x00FF) {
+                    case 0x0000:
+                        // F000 nnnn - LD I, long addr (XO-CHIP), the address is the next word
+                        if(x != 0) {
+                            pc += 2;
+                            return false;
+                        }
+                        if(pc > RAM_SIZE - 4) {
+                            faults |= FAULT_PC_OUT_OF_RANGE;
+                            pc += 2;
+                            return false;
+                        }
+                        I = (uint16_t)(memory.read(pc+2) << 8) | (uint16_t)(memory.read(pc+3));
+                        pc += 4;
+                        break;
+                    case 0x0001:
+                        // Fn01 - PLANE n (XO-CHIP), there are two planes
+                        planes = x & 0x3;
+                        pc += 2;
+                        break;
+                    case 0x0002:
+                        // F002 - AUDIO (XO-CHIP), load the 16-byte audio pattern from I
+                        if(x != 0) {
+                            pc += 2;
+                            return false;
+                        }
+                        if(I + AUDIO_PATTERN_SIZE > RAM_SIZE) {
+                            faults |= FAULT_I_OUT_OF_RANGE;
+                            pc += 2;
+                            return false;
+                        }
+                        for(int i = 0; i < AUDIO_PATTERN_SIZE; i++) {
+                            audioPattern[i] = memory.read(I + i);
+                        }
+                        audioPatternLoaded = true;
+                        pc += 2;
+                        break;
                     case 0x0007:
                         // Fx07 - LD Vx, DT
                         vx = dt;
@@ -247,8 +372,8 @@ namespace yac8 {
                         pc += 2;
                         break;
                     case 0x001E:
-                        // Fx1E - ADD I, Vx
-                        v[0xf] = (I + vx > 0xFFF) ? 1 : 0;
+                        // Fx1E - ADD I, Vx. VF is left alone: only the Amiga interpreter set it on overflow past
+                        // 0xFFF, and XO-CHIP programs legitimately point I above that
                         I += vx;
                         pc += 2;
                         break;
@@ -257,19 +382,39 @@ namespace yac8 {
                         I = 5 * vx;
                         pc += 2;
                         break;
+                    case 0x0030:
+                        // Fx30 - LD HF, Vx (SUPER-CHIP), the 8x10 digit for the low nibble of Vx
+                        I = BIG_TYPOGRAPHY_OFFSET + 10 * (vx & 0xF);
+                        pc += 2;
+                        break;
                     case 0x0033:
                         // Fx33 - LD B, Vx
                         // Store BCD representation of Vx in memory locations I, I+1, and I+2.
-                        ram[I] = vx / 100; // hundreds
-                        ram[I+1] = (vx % 100) / 10; // tens
-                        ram[I+2] = vx % 10; // ones
+                        if(I + 3 > RAM_SIZE) {
+                            faults |= FAULT_I_OUT_OF_RANGE;
+                            pc += 2;
+                            return false;
+                        }
+                        memory.write(I, vx / 100); // hundreds
+                        memory.write(I+1, (vx % 100) / 10); // tens
+                        memory.write(I+2, vx % 10); // ones
+                        pc += 2;
+                        break;
+                    case 0x003A:
+                        // Fx3A - PITCH Vx (XO-CHIP)
+                        pitch = vx;
                         pc += 2;
                         break;
                     case 0x0055:
                         // Fx55 - LD [I], Vx
                         // Store registers V0 through Vx in memory starting at location I.
+                        if(I + x + 1 > RAM_SIZE) {
+                            faults |= FAULT_I_OUT_OF_RANGE;
+                            pc += 2;
+                            return false;
+                        }
                         for(int i = 0; i <= x; i++) {
-                            ram[I + i] = v[i];
+                            memory.write(I + i, v[i]);
                         }
                         if(!quirks.loadStoreQuirk) {
                             I += x + 1;
@@ -279,14 +424,29 @@ namespace yac8 {
                     case 0x0065:
                         // Fx65 - LD Vx, [I]
                         // Read registers V0 through Vx from memory starting at location I.
+                        if(I + x + 1 > RAM_SIZE) {
+                            faults |= FAULT_I_OUT_OF_RANGE;
+                            pc += 2;
+                            return false;
+                        }
                         for(int i = 0; i <= x; i++) {
-                            v[i] = ram[I + i];
+                            v[i] = memory.read(I + i);
                         }
                         if(!quirks.loadStoreQuirk) {
                             I += x + 1;
                         }
                         pc += 2;
                         break;
+                    case 0x0075:
+                        // Fx75 - LD R, Vx (SUPER-CHIP), store V0 through Vx in the RPL flags
+                        std::copy(v, v + x + 1, rpl);
+                        pc += 2;
+                        break;
+                    case 0x0085:
+                        // Fx85 - LD Vx, R (SUPER-CHIP), read V0 through Vx from the RPL flags
+                        std::copy(rpl, rpl + x + 1, v);
+                        pc += 2;
+                        break;
                     default:
                         pc += 2;
                         return false;
@@ -298,4 +458,6 @@ namespace yac8 {
         }
         return true;
     }
+
+    template bool c8_registers::execute<c8_paged_ram>(c8_paged_ram &, c8_hardware_api &, c8_quirks);
 }
\ No newline at end of file
@@ -9,13 +9,25 @@
 
 namespace yac8 {
     const uint8_t NO_LAST_KEY = 0xFF;
+    const int RPL_FLAGS_SIZE = 16;
+    const int AUDIO_PATTERN_SIZE = 16;
+    // Fx3A pitch at which the audio pattern plays at 4000 bits per second
+    const uint8_t DEFAULT_AUDIO_PITCH = 64;
+
+    // reasons an instruction was refused, accumulated in c8_registers::faults
+    enum c8_fault : uint8_t {
+        FAULT_PC_OUT_OF_RANGE = 1 << 0,
+        FAULT_STACK_OVERFLOW = 1 << 1,
+        FAULT_STACK_UNDERFLOW = 1 << 2,
+        // a memory access at I would run past the end of RAM
+        FAULT_I_OUT_OF_RANGE = 1 << 3
+    };
 
     /**
-     * This class contains all state associated with the Chip-8 "CPU", including registers, RAM, etc.
+     * The Chip-8 "CPU" registers, independent of how RAM is stored.
      * Some of these registers are "hardware registers" which can only be modified by `c8_emulator`
      */
-    class c8_state {
-    public:
+    struct c8_registers {
         // 16-bit program counter
         uint16_t pc = PROGRAM_OFFSET;
         // 8-bit stack pointer
@@ -34,13 +46,51 @@ namespace yac8 {
         bool keyStates[16] = {false};
         // set by c8_hardware, equals value of last key pressed
         uint8_t lastKey = NO_LAST_KEY;
+        // SUPER-CHIP persistent "RPL user flags", saved and loaded by Fx75/Fx85. XO-CHIP allows all 16
+        uint8_t rpl[RPL_FLAGS_SIZE] = {0};
+        // XO-CHIP bitplanes Dxyn, 00E0 and the scrolls draw to, selected by Fn01
+        uint8_t planes = 1;
+        // XO-CHIP sound: a 128-bit waveform loaded by F002, played while the sound timer runs at the rate set by
+        // Fx3A. Until a program loads one, the classic beep plays instead
+        uint8_t audioPattern[AUDIO_PATTERN_SIZE] = {0};
+        uint8_t pitch = DEFAULT_AUDIO_PITCH;
+        bool audioPatternLoaded = false;
+        // c8_fault flags for every refused instruction since reset
+        uint8_t faults = 0;
+
+    protected:
+        // executes the instruction at PC. `Memory` provides read(), write() and sprite() (see c8_state)
+        template<class Memory>
+        bool execute(Memory &memory, c8_hardware_api &hardware_api, c8_quirks quirks);
+    };
 
+    /**
+     * This class contains all state associated with the Chip-8 "CPU", including registers, RAM, etc.
+     */
+    class c8_state : public c8_registers {
+    public:
         // RAM, contains program memory, typography, etc.
         uint8_t ram[RAM_SIZE] = {0};
+        // how many times the program has written to each page of RAM (by Fx33, Fx55 or 5xy2), so whoever is
+        // watching memory only has to look at the pages whose count changed
+        uint32_t pageWrites[PAGE_COUNT] = {0};
+        // bumped every time RAM is replaced as a whole (ROM load, reset, snapshot restore), which invalidates
+        // everything a watcher knows
+        uint32_t reloads = 0;
 
         c8_state();
-        void loadTypography(const uint16_t *typography);
+        void loadTypography(const uint16_t *typography,
+                            const uint16_t *bigTypography = yac8::default_big_typography_buffer);
         void loadROM(const uint8_t *rom, int size);
         bool step(c8_hardware_api &window, c8_quirks quirks);
+
+        // memory interface used by c8_registers::execute
+        uint8_t read(uint16_t addr) const { return ram[addr]; }
+        void write(uint16_t addr, uint8_t value) {
+            ram[addr] = value;
+            pageWrites[addr / PAGE_SIZE]++;
+        }
+        // flat RAM never needs `scratch`, sprites are read in place
+        const uint8_t *sprite(uint16_t addr, uint8_t /*n*/, uint8_t * /*scratch*/) const { return ram + addr; }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,83 @@
+#include "c8_trace_events.hpp"
+
+#ifdef YAC8_TRACE_EVENTS
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace yac8 {
+    namespace trace_events {
+        std::atomic<uint32_t> activeCapture{0};
+        static uint32_t lastCapture = 0;
+
+        // buffers outlive their threads, so a capture can still be written after a thread has exited
+        static std::mutex registryMutex;
+        static std::vector<std::unique_ptr<thread_buffer>> registry;
+
+        thread_buffer &threadBuffer() {
+            thread_local thread_buffer *buffer = nullptr;
+            if(buffer == nullptr) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                registry.emplace_back(new thread_buffer());
+                buffer = registry.back().get();
+                buffer->id = (int) registry.size();
+                buffer->name = "thread " + std::to_string(buffer->id);
+            }
+            return *buffer;
+        }
+
+        void nameThread(const char *name) {
+            thread_buffer &buffer = threadBuffer();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer.name = name;
+        }
+
+        void start() {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            activeCapture.store(++lastCapture, std::memory_order_relaxed);
+        }
+
+        bool isCapturing() {
+            return activeCapture.load(std::memory_order_relaxed) != 0;
+        }
+
+        bool stop(const std::string &path) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            uint32_t capture = activeCapture.exchange(0, std::memory_order_relaxed);
+
+            std::ofstream os(path, std::ios::out | std::ios::trunc);
+            if(!os.is_open())
+                return false;
+
+            // timestamps are relative to the earliest event, in microseconds
+            int64_t origin = INT64_MAX;
+            for(const std::unique_ptr<thread_buffer> &buffer : registry) {
+                if(buffer->capture.load(std::memory_order_acquire) == capture && buffer->size.load(std::memory_order_acquire) > 0)
+                    origin = std::min(origin, buffer->events[0].begin);
+            }
+
+            os << "{\"traceEvents\":[\n";
+            bool first = true;
+            for(const std::unique_ptr<thread_buffer> &buffer : registry) {
+                os << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                   << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+                first = false;
+                if(buffer->capture.load(std::memory_order_acquire) != capture)
+                    continue;
+                int size = buffer->size.load(std::memory_order_acquire);
+                for(int i = 0; i < size; i++) {
+                    const event &e = buffer->events[i];
+                    os << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                       << ",\"ts\":" << (e.begin - origin) / 1000.0 << ",\"dur\":" << (e.end - e.begin) / 1000.0 << "}";
+                }
+            }
+            os << "\n]}\n";
+            return true;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+/**
+ * Scoped timing of the emulator's main phases on every thread, exported as Chrome trace-event JSON (open it in
+ * chrome://tracing or Perfetto) to see where threads stall each other. Only built when YAC8_TRACE_EVENTS is
+ * defined (the YAC8_TRACE_EVENTS CMake option); otherwise the macros below compile to nothing.
+ *
+ *     YAC8_TRACE_THREAD("render");
+ *     { YAC8_TRACE_SCOPE("swap"); SDL_GL_SwapWindow(window); }
+ */
+
+#ifdef YAC8_TRACE_EVENTS
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace yac8 {
+    namespace trace_events {
+        struct event {
+            const char *name;
+            int64_t begin;
+            int64_t end;
+        };
+
+        const int EVENTS_PER_THREAD = 1 << 16;
+
+        /**
+         * One thread's events. Only the owning thread writes to it; the exporter reads up to `size`.
+         */
+        struct thread_buffer {
+            event events[EVENTS_PER_THREAD];
+            std::atomic<int> size{0};
+            // the capture these events belong to; the owner empties its buffer when a new capture starts
+            std::atomic<uint32_t> capture{0};
+            std::string name;
+            int id = 0;
+        };
+
+        extern std::atomic<uint32_t> activeCapture;
+
+        thread_buffer &threadBuffer();
+        void nameThread(const char *name);
+
+        inline int64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        inline void record(const char *name, int64_t begin, int64_t end) {
+            uint32_t capture = activeCapture.load(std::memory_order_relaxed);
+            if(capture == 0)
+                return;
+            thread_buffer &buffer = threadBuffer();
+            if(buffer.capture.load(std::memory_order_relaxed) != capture) {
+                buffer.size.store(0, std::memory_order_relaxed);
+                buffer.capture.store(capture, std::memory_order_release);
+            }
+            int i = buffer.size.load(std::memory_order_relaxed);
+            if(i == EVENTS_PER_THREAD)
+                return;
+            buffer.events[i] = {name, begin, end};
+            buffer.size.store(i + 1, std::memory_order_release);
+        }
+
+        // starts recording on every thread
+        void start();
+        // stops recording, and writes what was captured to `path`
+        bool stop(const std::string &path);
+        bool isCapturing();
+
+        class scope {
+            const char *name;
+            int64_t begin;
+        public:
+            explicit scope(const char *name) : name(name), begin(now()) {}
+            ~scope() { record(name, begin, now()); }
+        };
+    }
+}
+
+#define YAC8_TRACE_CONCAT_(a, b) a##b
+#define YAC8_TRACE_CONCAT(a, b) YAC8_TRACE_CONCAT_(a, b)
+#define YAC8_TRACE_SCOPE(name) yac8::trace_events::scope YAC8_TRACE_CONCAT(yac8_trace_scope_, __LINE__)(name)
+#define YAC8_TRACE_THREAD(name) yac8::trace_events::nameThread(name)
+
+#else
+
+#define YAC8_TRACE_SCOPE(name) ((void) 0)
+#define YAC8_TRACE_THREAD(name) ((void) 0)
+
+#endif
@@ -0,0 +1,163 @@
+#include "c8_tracer.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace yac8 {
+    const char TRACE_MAGIC[8] = {'Y','A','C','8','T','R','C','E'};
+    const uint32_t TRACE_VERSION = 2;
+
+    static void put(std::ostream &out, uint64_t value, int bytes) {
+        char buffer[8];
+        for(int i = 0; i < bytes; i++) {
+            buffer[i] = static_cast<char>(value >> (8 * i));
+        }
+        out.write(buffer, bytes);
+    }
+
+    c8_tracer::~c8_tracer() {
+        stop();
+    }
+
+    bool c8_tracer::start(const std::string &path, const c8_quirks &quirks) {
+        if(draining)
+            return false;
+        out.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!out.is_open())
+            return false;
+        out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        put(out, TRACE_VERSION, 4);
+        put(out, packQuirks(quirks), 2);
+
+        // every block is back in `empty` once a trace has stopped, so they're only handed out the first time
+        if(!storage) {
+            storage.reset(new c8_trace_record[BLOCK_COUNT * BLOCK_RECORDS]);
+            for(size_t i = 0; i < BLOCK_COUNT; i++) {
+                empty->push(block{storage.get() + i * BLOCK_RECORDS, 0});
+            }
+        }
+        empty->pop(current);
+        current.size = 0;
+
+        stalls = 0;
+        draining = true;
+        drainer = std::thread([this]() { drainThread(); });
+        return true;
+    }
+
+    void c8_tracer::stop() {
+        if(!draining)
+            return;
+        // the last, partly filled block. There's always room for it, there are only BLOCK_COUNT blocks
+        full->push(current);
+        current = block{nullptr, 0};
+        draining = false;
+        wake.notify_one();
+        drainer.join();
+    }
+
+    void c8_tracer::flush() {
+        full->push(current);
+        wake.notify_one();
+        if(!empty->pop(current)) {
+            stalls++;
+            while(!empty->pop(current)) {
+                wake.notify_one();
+                std::this_thread::yield();
+            }
+        }
+        current.size = 0;
+    }
+
+    void c8_tracer::drainThread() {
+        // records are encoded into a buffer and written in large chunks, so the drainer keeps up with the core
+        const size_t BUFFER_SIZE = 1 << 16;
+        // flags, opcode, long address, cycle, pc, I, sp, V mask, V registers
+        const size_t MAX_RECORD_SIZE = 1 + 2 + 2 + 10 + 2 + 2 + 1 + 2 + V_REGISTERS_SIZE;
+        std::unique_ptr<char[]> buffer(new char[BUFFER_SIZE]);
+        size_t used = 0;
+
+        // what the previous record left behind; the first record carries everything
+        uint64_t nextCycle = UINT64_MAX;
+        uint16_t nextPC = 0, lastI = 0;
+        uint8_t lastSP = 0;
+        uint8_t lastV[V_REGISTERS_SIZE] = {0};
+        auto put16 = [](char *p, uint16_t value) {
+            p[0] = static_cast<char>(value);
+            p[1] = static_cast<char>(value >> 8);
+            return p + 2;
+        };
+
+        block b;
+        while(true) {
+            // check before draining, so that everything recorded before stop() is written
+            bool finishing = !draining;
+            int drained = 0;
+            while(full->pop(b)) {
+                for(size_t i = 0; i < b.size; i++) {
+                    const c8_trace_record &record = b.records[i];
+                    char *flags = buffer.get() + used;
+                    char *p = flags + 1;
+                    uint8_t f = 0;
+                    p = put16(p, record.opcode);
+                    if(record.opcode == 0xF000)
+                        p = put16(p, record.longAddress);
+                    if(record.cycle != nextCycle) {
+                        // after a gap (reset, rewind, the start of the trace) nothing is predicted
+                        f |= TRACE_CYCLE | TRACE_PC;
+                        uint64_t c = record.cycle;
+                        for(; c >= 0x80; c >>= 7) {
+                            *p++ = static_cast<char>((c & 0x7F) | 0x80);
+                        }
+                        *p++ = static_cast<char>(c);
+                    } else if(record.pc != nextPC) {
+                        f |= TRACE_PC;
+                    }
+                    if(f & TRACE_PC)
+                        p = put16(p, record.pc);
+                    if(record.I != lastI) {
+                        f |= TRACE_I;
+                        p = put16(p, lastI = record.I);
+                    }
+                    if(record.sp != lastSP) {
+                        f |= TRACE_SP;
+                        *p++ = static_cast<char>(lastSP = record.sp);
+                    }
+                    if(std::memcmp(record.v, lastV, sizeof(lastV)) != 0) {
+                        f |= TRACE_V;
+                        char *mask = p;
+                        p += 2;
+                        uint16_t changed = 0;
+                        for(int r = 0; r < V_REGISTERS_SIZE; r++) {
+                            if(record.v[r] != lastV[r]) {
+                                changed |= 1 << r;
+                                *p++ = static_cast<char>(lastV[r] = record.v[r]);
+                            }
+                        }
+                        put16(mask, changed);
+                    }
+                    *flags = static_cast<char>(f);
+                    nextCycle = record.cycle + 1;
+                    nextPC = static_cast<uint16_t>(record.pc + (record.opcode == 0xF000 ? 4 : 2));
+
+                    used = p - buffer.get();
+                    if(used > BUFFER_SIZE - MAX_RECORD_SIZE) {
+                        out.write(buffer.get(), used);
+                        used = 0;
+                    }
+                }
+                empty->push(b);
+                drained++;
+            }
+            if(finishing)
+                break;
+            if(drained == 0) {
+                // a wakeup can slip in between the check and the wait, so don't wait on it for long
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+        out.write(buffer.get(), used);
+        out.close();
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "c8_constants.hpp"
+#include "c8_quirks.hpp"
+#include "c8_ring_buffer.hpp"
+#include "c8_state.hpp"
+
+namespace yac8 {
+    // which fields a trace record carries besides its opcode; everything else is predicted from the record before
+    enum c8_trace_flags : uint8_t {
+        // varint cycle, when it isn't the one after the previous record's
+        TRACE_CYCLE = 1 << 0,
+        // u16 pc, when it isn't the address after the previous instruction
+        TRACE_PC = 1 << 1,
+        // u16 I, when it changed
+        TRACE_I = 1 << 2,
+        // u8 sp, when it changed
+        TRACE_SP = 1 << 3,
+        // u16 mask of the V registers that changed, then one byte per changed register
+        TRACE_V = 1 << 4
+    };
+
+    /**
+     * One executed instruction, as seen right after it ran.
+     */
+    struct c8_trace_record {
+        uint64_t cycle;
+        uint16_t pc;
+        uint16_t opcode;
+        // the word after an F000, which is its address
+        uint16_t longAddress;
+        uint16_t I;
+        uint8_t sp;
+        uint8_t v[V_REGISTERS_SIZE];
+    };
+
+    /**
+     * Records every instruction a single machine executes into a compact binary trace file. Decode traces with the
+     * yac8-tracedump tool.
+     *
+     * The machine's thread only copies each record into a block, and hands whole blocks to a background thread
+     * through a lock-free ring. That thread encodes them, writes them out and hands the blocks back. An encoded record
+     * only holds what changed since the one before it, so the common case is a flags byte and the opcode.
+     *
+     * File layout, little-endian: "YAC8TRCE", u32 version, u16 quirks, then per record: u8 c8_trace_flags, u16
+     * opcode, u16 long address if the opcode is F000, then the fields the flags select, in their order.
+     */
+    class c8_tracer {
+        static const size_t BLOCK_RECORDS = 4096;
+        static const size_t BLOCK_COUNT = 32;
+
+        struct block {
+            c8_trace_record *records;
+            size_t size;
+        };
+        typedef c8_ring_buffer<block, BLOCK_COUNT> block_ring;
+
+        std::unique_ptr<c8_trace_record[]> storage;
+        // blocks waiting to be written, and written blocks waiting to be reused
+        std::unique_ptr<block_ring> full{new block_ring()};
+        std::unique_ptr<block_ring> empty{new block_ring()};
+        // the block the machine's thread is filling
+        block current{nullptr, 0};
+        std::ofstream out;
+        std::thread drainer;
+        std::atomic<bool> draining{false};
+        // the drainer sleeps on this while there's nothing to write; flush() wakes it with each full block
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        // times the machine had to wait for the drainer to catch up
+        std::atomic<uint64_t> stalls{0};
+
+        // hands the current block to the drainer and takes an empty one, waiting for one if there are none
+        void flush();
+        void drainThread();
+    public:
+        ~c8_tracer();
+
+        bool start(const std::string &path, const c8_quirks &quirks);
+        // waits until everything recorded has been written. Detach the tracer from its machine first
+        void stop();
+        bool isTracing() const { return draining; }
+        uint64_t getStalls() const { return stalls; }
+
+        // called by the traced machine's thread right after an instruction ran, with the registers it left.
+        // Never drops a record: when every block is full it waits for the drainer
+        void record(uint64_t cycle, uint16_t pc, uint16_t opcode, uint16_t longAddress, const c8_registers &after) {
+            c8_trace_record &r = current.records[current.size];
+            r.cycle = cycle;
+            r.pc = pc;
+            r.opcode = opcode;
+            r.longAddress = longAddress;
+            r.I = after.I;
+            r.sp = after.sp;
+            std::memcpy(r.v, after.v, sizeof(r.v));
+            if(++current.size == BLOCK_RECORDS)
+                flush();
+        }
+    };
+}
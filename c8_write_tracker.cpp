@@ -0,0 +1,38 @@
+#include "c8_write_tracker.hpp"
+
+#include <cstring>
+
+namespace yac8 {
+    c8_write_tracker::c8_write_tracker() {
+        std::memset(image, 0, sizeof(image));
+        std::memset(seenWrites, 0, sizeof(seenWrites));
+        std::memset(changedIn, 0, sizeof(changedIn));
+    }
+
+    void c8_write_tracker::resync(const c8_state &state) {
+        std::memcpy(image, state.ram, sizeof(image));
+        std::memcpy(seenWrites, state.pageWrites, sizeof(seenWrites));
+        std::memset(changedIn, 0, sizeof(changedIn));
+        seenReloads = state.reloads;
+    }
+
+    uint32_t c8_write_tracker::update(const c8_state &state) {
+        generation++;
+        if(state.reloads != seenReloads) {
+            resync(state);
+            return generation;
+        }
+        for(int p = 0; p < PAGE_COUNT; p++) {
+            if(state.pageWrites[p] == seenWrites[p])
+                continue;
+            seenWrites[p] = state.pageWrites[p];
+            for(int addr = p * PAGE_SIZE; addr < (p + 1) * PAGE_SIZE; addr++) {
+                if(image[addr] != state.ram[addr]) {
+                    image[addr] = state.ram[addr];
+                    changedIn[addr] = generation;
+                }
+            }
+        }
+        return generation;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "c8_constants.hpp"
+#include "c8_state.hpp"
+
+namespace yac8 {
+    /**
+     * Remembers which frame each byte of RAM last changed in, for the memory viewer.
+     * It belongs to whoever is watching rather than to c8_state, so states nobody watches don't carry it. update()
+     * only compares the pages c8_state::pageWrites says were written to since the last call, against its own copy
+     * of RAM; a write that stores the value already there doesn't show.
+     */
+    class c8_write_tracker {
+        uint8_t image[RAM_SIZE];
+        uint32_t seenWrites[PAGE_COUNT];
+        uint32_t seenReloads = 0;
+        uint32_t changedIn[RAM_SIZE];
+        uint32_t generation = 1;
+
+        void resync(const c8_state &state);
+    public:
+        c8_write_tracker();
+
+        // stamps whatever the program changed since the last call with a new generation, and returns it. Meant to be
+        // called once per frame with the state locked. After a reset or rewind it starts over with nothing stamped
+        uint32_t update(const c8_state &state);
+        // the generation `addr` last changed in, 0 if it hasn't since the last reset or rewind
+        uint32_t writtenIn(uint16_t addr) const { return changedIn[addr]; }
+    };
+}
@@ -1,9 +1,80 @@
 #include "c8_emulator.hpp"
 
-int main()
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// replays a recorded movie headlessly, as fast as the core can run
+int replay(const char *movieFilename, const char *romFilename, const char *profileFilename, const char *stacksFilename,
+           const char *opstatsFilename) {
+    yac8::c8_movie movie;
+    if(!movie.load(movieFilename)) {
+        std::cerr << "Could not read movie " << movieFilename << std::endl;
+        return 1;
+    }
+    std::ifstream is(romFilename, std::ios::in | std::ios::binary);
+    std::vector<char> romData((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    yac8::c8_machine machine;
+    std::unique_ptr<yac8::c8_profiler> profiler(new yac8::c8_profiler());
+    if(profileFilename != nullptr || stacksFilename != nullptr)
+        machine.setProfiler(profiler.get());
+    std::unique_ptr<yac8::c8_opcode_stats> opcodeStats(new yac8::c8_opcode_stats());
+    if(opstatsFilename != nullptr)
+        machine.setOpcodeStats(opcodeStats.get());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if(!movie.play(machine, (const uint8_t *) romData.data(), (int) romData.size())) {
+        std::cerr << romFilename << " is not the ROM this movie was recorded with" << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << "cycles: " << machine.cycle << std::endl;
+    std::cout << "seconds: " << elapsed.count() << std::endl;
+    std::cout << "state hash: " << std::hex << machine.hash() << std::endl;
+
+    if(profileFilename != nullptr && !profiler->writeCSV(profileFilename)) {
+        std::cerr << "Could not write " << profileFilename << std::endl;
+        return 1;
+    }
+    if(stacksFilename != nullptr && !profiler->writeCollapsedStacks(stacksFilename)) {
+        std::cerr << "Could not write " << stacksFilename << std::endl;
+        return 1;
+    }
+    if(opstatsFilename != nullptr && !opcodeStats->writeCSV(opstatsFilename)) {
+        std::cerr << "Could not write " << opstatsFilename << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
 {
+    if(argc >= 4 && std::strcmp(argv[1], "--replay") == 0) {
+        const char *profileFilename = nullptr;
+        const char *stacksFilename = nullptr;
+        const char *opstatsFilename = nullptr;
+        for(int i = 4; i < argc; i += 2) {
+            if(i + 1 < argc && std::strcmp(argv[i], "--profile") == 0) {
+                profileFilename = argv[i + 1];
+            } else if(i + 1 < argc && std::strcmp(argv[i], "--stacks") == 0) {
+                stacksFilename = argv[i + 1];
+            } else if(i + 1 < argc && std::strcmp(argv[i], "--opstats") == 0) {
+                opstatsFilename = argv[i + 1];
+            } else {
+                std::cerr << "usage: yac8 --replay <movie> <rom> [--profile <csv>] [--stacks <txt>] [--opstats <csv>]" << std::endl;
+                return 1;
+            }
+        }
+        return replay(argv[2], argv[3], profileFilename, stacksFilename, opstatsFilename);
+    }
+
     yac8::c8_emulator emu;
     emu.run();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Small self-checking ROMs for the instructions the bundled games don't exercise. Each test records whether it
+ * passed, then the ROM draws one mark per test: a filled square for a pass, an X for a failure. yac8-golden hashes
+ * what they draw, so a golden line for one of these only stays valid while every test passes.
+ */
+
+namespace yac8 {
+    // SUPER-CHIP: resolution switching, 16x16 sprites, the big font, the scrolls and the RPL flags
+    const uint8_t SCHIP_TEST_ROM[] = {
+            0x66,0x00,               // LD   V6, 0x00
+            // 0: 00FF/00FE switch resolution and clear; x wraps at the width of the current one
+            0x00,0xFF,               // HIGH
+            0x6C,0x01,               // LD   VC, 0x01
+            0x61,0x00,               // LD   V1, 0x00
+            0x62,0x00,               // LD   V2, 0x00
+            0xA3,0x00,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x61,0x40,               // LD   V1, 0x40
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x00,               // SE   VF, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0x00,0xFE,               // LOW
+            0x61,0x00,               // LD   V1, 0x00
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x00,               // SE   VF, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0x61,0x40,               // LD   V1, 0x40
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x22,0xEE,               // CALL record
+            0x00,0xFF,               // HIGH
+            // 1: Dxy0 draws 16x16, two bytes per row
+            0x6C,0x01,               // LD   VC, 0x01
+            0x61,0x0A,               // LD   V1, 0x0a
+            0x62,0x0A,               // LD   V2, 0x0a
+            0xA3,0x01,               // LD   I, corners
+            0xD1,0x20,               // DRW  V1, V2, 0
+            0x63,0x19,               // LD   V3, 0x19
+            0x64,0x19,               // LD   V4, 0x19
+            0xA3,0x00,               // LD   I, dot
+            0xD3,0x41,               // DRW  V3, V4, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x63,0x18,               // LD   V3, 0x18
+            0xD3,0x41,               // DRW  V3, V4, 1
+            0x3F,0x00,               // SE   VF, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0xD3,0x41,               // DRW  V3, V4, 1
+            0x00,0xE0,               // CLS
+            0x22,0xEE,               // CALL record
+            // 2: Fx30 points I at the 8x10 digit
+            0x6C,0x01,               // LD   VC, 0x01
+            0x61,0x01,               // LD   V1, 0x01
+            0xF1,0x30,               // LD   HF, V1
+            0xF0,0x65,               // LD   V0, [I]
+            0x30,0x18,               // SE   V0, 0x18
+            0x6C,0x00,               // LD   VC, 0x00
+            0x61,0x0A,               // LD   V1, 0x0a
+            0xF1,0x30,               // LD   HF, V1
+            0xF0,0x65,               // LD   V0, [I]
+            0x30,0x3C,               // SE   V0, 0x3c
+            0x6C,0x00,               // LD   VC, 0x00
+            0x22,0xEE,               // CALL record
+            // 3: 00Cn scrolls down n pixels
+            0x6C,0x01,               // LD   VC, 0x01
+            0x61,0x05,               // LD   V1, 0x05
+            0x62,0x05,               // LD   V2, 0x05
+            0xA3,0x00,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x00,0xC3,               // SCD  3
+            0x62,0x08,               // LD   V2, 0x08
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x62,0x05,               // LD   V2, 0x05
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x00,               // SE   VF, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x22,0xEE,               // CALL record
+            // 4: 00FB scrolls right 4 pixels
+            0x6C,0x01,               // LD   VC, 0x01
+            0xA3,0x00,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x00,0xFB,               // SCR
+            0x61,0x09,               // LD   V1, 0x09
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x22,0xEE,               // CALL record
+            // 5: 00FC scrolls left 4 pixels
+            0x6C,0x01,               // LD   VC, 0x01
+            0xA3,0x00,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x00,0xFC,               // SCL
+            0x61,0x05,               // LD   V1, 0x05
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x22,0xEE,               // CALL record
+            // 6: Fx75/Fx85 save and restore V0-Vx in the RPL flags
+            0x6C,0x01,               // LD   VC, 0x01
+            0x60,0x11,               // LD   V0, 0x11
+            0x61,0x22,               // LD   V1, 0x22
+            0x62,0x33,               // LD   V2, 0x33
+            0x63,0x44,               // LD   V3, 0x44
+            0xF3,0x75,               // LD   R, V3
+            0x60,0x00,               // LD   V0, 0x00
+            0x61,0x00,               // LD   V1, 0x00
+            0x62,0x00,               // LD   V2, 0x00
+            0x63,0x00,               // LD   V3, 0x00
+            0xF2,0x85,               // LD   V2, R
+            0x30,0x11,               // SE   V0, 0x11
+            0x6C,0x00,               // LD   VC, 0x00
+            0x32,0x33,               // SE   V2, 0x33
+            0x6C,0x00,               // LD   VC, 0x00
+            0x33,0x00,               // SE   V3, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0x22,0xEE,               // CALL record
+            // marks:
+            0x65,0x00,               // LD   V5, 0x00
+            0x6E,0x01,               // LD   VE, 0x01
+            0x6D,0x01,               // LD   VD, 0x01
+            // next_mark:
+            0xA3,0x21,               // LD   I, results
+            0xF5,0x1E,               // ADD  I, V5
+            0xF0,0x65,               // LD   V0, [I]
+            0xA2,0xFD,               // LD   I, fail_mark
+            0x30,0x00,               // SE   V0, 0x00
+            0xA2,0xFA,               // LD   I, pass_mark
+            0xDE,0xD3,               // DRW  VE, VD, 3
+            0x7E,0x04,               // ADD  VE, 0x04
+            0x75,0x01,               // ADD  V5, 0x01
+            0x35,0x07,               // SE   V5, 0x07
+            0x12,0xD6,               // JP   next_mark
+            0x00,0xFD,               // EXIT
+            // record:
+            // stores VC, 1 if the test passed, as result V6
+            0xA3,0x21,               // LD   I, results
+            0xF6,0x1E,               // ADD  I, V6
+            0x80,0xC0,               // LD   V0, VC
+            0xF0,0x55,               // LD   [I], V0
+            0x76,0x01,               // ADD  V6, 0x01
+            0x00,0xEE,               // RET
+            // pass_mark:
+            0xE0,0xE0,0xE0,          // a filled square
+            // fail_mark:
+            0xA0,0x40,0xA0,          // an X
+            // dot:
+            0x80,                    // one pixel
+            // corners:
+            0x80,0x01,0x00,0x00,0x00,0x00,0x00,0x00, // 16x16, only the corners lit
+            0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+            0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+            0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x01,
+            // results:
+            0x00,0x00,0x00,0x00,0x00,0x00,0x00, // one byte per test
+    };
+
+    // XO-CHIP: long I, the skip over it, 5xy2/5xy3, bitplanes, 00Dn, the audio pattern and all 16 RPL flags.
+    // It also leaves a pixel in each color, and the pattern and pitch it loads are part of its golden hash
+    const uint8_t XO_CHIP_TEST_ROM[] = {
+            0x66,0x00,               // LD   V6, 0x00
+            // 0: F000 nnnn loads I from the next word; a skip steps over all 4 bytes; Fx1E leaves VF alone
+            0x6C,0x01,               // LD   VC, 0x01
+            0x60,0xAB,               // LD   V0, 0xab
+            0xF0,0x00,0x12,0x34,     // LD   I, 0x1234
+            0xF0,0x55,               // LD   [I], V0
+            0x60,0x00,               // LD   V0, 0x00
+            0xF0,0x00,0x12,0x34,     // LD   I, 0x1234
+            0xF0,0x65,               // LD   V0, [I]
+            0x30,0xAB,               // SE   V0, 0xab
+            0x6C,0x00,               // LD   VC, 0x00
+            0x61,0x00,               // LD   V1, 0x00
+            0x31,0x00,               // SE   V1, 0x00
+            0xF0,0x00,0x6C,0x00,     // skipped, or LD VC, 0 runs
+            0x6F,0x55,               // LD   VF, 0x55
+            0xF0,0x00,0x0F,0xFF,     // LD   I, 0x0fff
+            0x61,0x02,               // LD   V1, 0x02
+            0xF1,0x1E,               // ADD  I, V1
+            0x3F,0x55,               // SE   VF, 0x55
+            0x6C,0x00,               // LD   VC, 0x00
+            0x23,0x1A,               // CALL record
+            // 1: 5xy2/5xy3 save and load Vx-Vy in either order, and leave I alone
+            0x6C,0x01,               // LD   VC, 0x01
+            0x62,0x01,               // LD   V2, 0x01
+            0x63,0x02,               // LD   V3, 0x02
+            0x64,0x03,               // LD   V4, 0x03
+            0xA3,0x3F,               // LD   I, scratch
+            0x52,0x42,               // LD   [I], V2-V4
+            0x62,0x00,               // LD   V2, 0x00
+            0x63,0x00,               // LD   V3, 0x00
+            0x64,0x00,               // LD   V4, 0x00
+            0x52,0x43,               // LD   V2-V4, [I]
+            0x32,0x01,               // SE   V2, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x33,0x02,               // SE   V3, 0x02
+            0x6C,0x00,               // LD   VC, 0x00
+            0x34,0x03,               // SE   V4, 0x03
+            0x6C,0x00,               // LD   VC, 0x00
+            0x54,0x22,               // LD   [I], V4-V2
+            0x52,0x43,               // LD   V2-V4, [I]
+            0x32,0x03,               // SE   V2, 0x03
+            0x6C,0x00,               // LD   VC, 0x00
+            0x34,0x01,               // SE   V4, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x23,0x1A,               // CALL record
+            // 2: Fn01 selects the planes Dxyn and 00E0 work on; each plane gets its own sprite data
+            0x6C,0x01,               // LD   VC, 0x01
+            0x61,0x05,               // LD   V1, 0x05
+            0x62,0x05,               // LD   V2, 0x05
+            0xF1,0x01,               // PLANE 1
+            0xA3,0x2C,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0xF2,0x01,               // PLANE 2
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x00,               // SE   VF, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0xF1,0x01,               // PLANE 1
+            0x00,0xE0,               // CLS
+            0xF2,0x01,               // PLANE 2
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0xF3,0x01,               // PLANE 3
+            0xA3,0x2D,               // LD   I, two_planes
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x00,               // SE   VF, 0x00
+            0x6C,0x00,               // LD   VC, 0x00
+            0xF1,0x01,               // PLANE 1
+            0xA3,0x2C,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0xF2,0x01,               // PLANE 2
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x23,0x1A,               // CALL record
+            // 3: 00Dn scrolls the selected planes up n pixels
+            0x6C,0x01,               // LD   VC, 0x01
+            0x62,0x0A,               // LD   V2, 0x0a
+            0xF3,0x01,               // PLANE 3
+            0xA3,0x2C,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0xF1,0x01,               // PLANE 1
+            0x00,0xD2,               // SCU  2
+            0x62,0x08,               // LD   V2, 0x08
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0xF2,0x01,               // PLANE 2
+            0x62,0x0A,               // LD   V2, 0x0a
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0x3F,0x01,               // SE   VF, 0x01
+            0x6C,0x00,               // LD   VC, 0x00
+            0x23,0x1A,               // CALL record
+            // 4: F002 loads the audio pattern at I without moving I, Fx3A sets the pitch
+            0x6C,0x01,               // LD   VC, 0x01
+            0xA3,0x2F,               // LD   I, pattern
+            0xF0,0x02,               // AUDIO
+            0x61,0x64,               // LD   V1, 0x64
+            0xF1,0x3A,               // PITCH V1
+            0xF0,0x65,               // LD   V0, [I]
+            0x30,0xF0,               // SE   V0, 0xf0
+            0x6C,0x00,               // LD   VC, 0x00
+            0x23,0x1A,               // CALL record
+            // 5: Fx75/Fx85 save and restore all 16 registers
+            0x60,0x10,               // LD   V0, 0x10
+            0x6F,0x1F,               // LD   VF, 0x1f
+            0xFF,0x75,               // LD   R, VF
+            0x60,0x00,               // LD   V0, 0x00
+            0x6F,0x00,               // LD   VF, 0x00
+            0xFF,0x85,               // LD   VF, R
+            0x6C,0x01,               // LD   VC, 0x01
+            0x30,0x10,               // SE   V0, 0x10
+            0x6C,0x00,               // LD   VC, 0x00
+            0x3F,0x1F,               // SE   VF, 0x1f
+            0x6C,0x00,               // LD   VC, 0x00
+            0x23,0x1A,               // CALL record
+            // a pixel in each color, then the marks on plane 1
+            0xF3,0x01,               // PLANE 3
+            0x61,0x28,               // LD   V1, 0x28
+            0x62,0x14,               // LD   V2, 0x14
+            0xA3,0x2D,               // LD   I, two_planes
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0xF2,0x01,               // PLANE 2
+            0x61,0x2C,               // LD   V1, 0x2c
+            0xA3,0x2C,               // LD   I, dot
+            0xD1,0x21,               // DRW  V1, V2, 1
+            0xF1,0x01,               // PLANE 1
+            // marks:
+            0x65,0x00,               // LD   V5, 0x00
+            0x6E,0x01,               // LD   VE, 0x01
+            0x6D,0x01,               // LD   VD, 0x01
+            // next_mark:
+            0xA3,0x42,               // LD   I, results
+            0xF5,0x1E,               // ADD  I, V5
+            0xF0,0x65,               // LD   V0, [I]
+            0xA3,0x29,               // LD   I, fail_mark
+            0x30,0x00,               // SE   V0, 0x00
+            0xA3,0x26,               // LD   I, pass_mark
+            0xDE,0xD3,               // DRW  VE, VD, 3
+            0x7E,0x04,               // ADD  VE, 0x04
+            0x75,0x01,               // ADD  V5, 0x01
+            0x35,0x06,               // SE   V5, 0x06
+            0x13,0x02,               // JP   next_mark
+            0x00,0xFD,               // EXIT
+            // record:
+            // stores VC, 1 if the test passed, as result V6
+            0xA3,0x42,               // LD   I, results
+            0xF6,0x1E,               // ADD  I, V6
+            0x80,0xC0,               // LD   V0, VC
+            0xF0,0x55,               // LD   [I], V0
+            0x76,0x01,               // ADD  V6, 0x01
+            0x00,0xEE,               // RET
+            // pass_mark:
+            0xE0,0xE0,0xE0,          // a filled square
+            // fail_mark:
+            0xA0,0x40,0xA0,          // an X
+            // dot:
+            0x80,                    // one pixel
+            // two_planes:
+            0x80,0x80,               // one pixel on each plane
+            // pattern:
+            0xF0,0xF0,0xF0,0xF0,0xF0,0xF0,0xF0,0xF0, // a square wave
+            0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+            // scratch:
+            0x00,0x00,0x00,          // for 5xy2/5xy3
+            // results:
+            0x00,0x00,0x00,0x00,0x00,0x00, // one byte per test
+    };
+}
@@ -0,0 +1,194 @@
+/**
+ * Measures interpreter throughput over a corpus of ROMs, headlessly:
+ *
+ *     yac8-bench [--cycles N] [--repeat N] [--json results.json] [rom directory]
+ *
+ * Every ROM in the directory (c8games by default), plus the built-in demo, runs for a fixed number of guest cycles
+ * from the same seed with the same scripted input, so the final state hashes are stable and runs can be compared.
+ * Each ROM is timed `repeat` times and the fastest run is reported.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "c8_demo_rom.hpp"
+#include "c8_input_script.hpp"
+#include "c8_machine.hpp"
+#include "c8_opcode_stats.hpp"
+
+using namespace yac8;
+
+const uint32_t BENCH_SEED = 0xC8;
+
+struct bench_result {
+    std::string name;
+    double mips = 0;
+    double nsPerInstruction = 0;
+    double drawsPerSecond = 0;
+    double drawShare = 0;
+    long peakRssKb = -1;
+    uint64_t hash = 0;
+};
+
+// peak resident set size of the whole process so far, or -1 where that isn't available
+static long peakRssKb() {
+#if defined(__APPLE__)
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+#elif defined(__unix__)
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return -1;
+#endif
+}
+
+// runs `cycles` guest cycles in frames, feeding the scripted input at the start of each one
+static void run(c8_machine &machine, const std::vector<char> &rom, uint64_t cycles) {
+    machine.reset((const uint8_t *) rom.data(), (int) rom.size(), BENCH_SEED);
+    c8_input_script script(BENCH_SEED);
+    const uint64_t cyclesPerFrame = std::max(1, machine.processorSpeed / TIMER_FREQUENCY);
+    while(machine.cycle < cycles) {
+        script.frame(machine);
+        uint64_t frameEnd = std::min(cycles, machine.cycle + cyclesPerFrame);
+        while(machine.cycle < frameEnd) {
+            machine.step();
+        }
+    }
+}
+
+static bench_result bench(const std::string &name, const std::vector<char> &rom, uint64_t cycles, int repeat) {
+    bench_result result;
+    result.name = name;
+    c8_machine machine;
+
+    double best = 0;
+    for(int i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run(machine, rom, cycles);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(i == 0 || seconds < best)
+            best = seconds;
+    }
+    result.hash = machine.hash();
+
+    // count draws on a separate, untimed run, so the timed runs stay uninstrumented. The run is deterministic
+    c8_opcode_stats stats;
+    stats.samplePeriod = UINT32_MAX;
+    machine.setOpcodeStats(&stats);
+    run(machine, rom, cycles);
+    machine.setOpcodeStats(nullptr);
+
+    best = std::max(best, 1e-9);
+    result.mips = cycles / best / 1e6;
+    result.nsPerInstruction = best * 1e9 / cycles;
+    result.drawsPerSecond = stats.counts[OP_DRW] / best;
+    result.drawShare = (double) stats.counts[OP_DRW] / cycles;
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+static std::string jsonString(const std::string &s) {
+    std::string out = "\"";
+    for(char c : s) {
+        if(c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static bool writeJSON(const std::string &path, const std::vector<bench_result> &results, uint64_t cycles, int repeat) {
+    std::ofstream os(path, std::ios::out | std::ios::trunc);
+    if(!os.is_open())
+        return false;
+    os << "{\n  \"cycles\": " << cycles << ",\n  \"repeat\": " << repeat << ",\n  \"seed\": " << BENCH_SEED
+       << ",\n  \"roms\": [\n";
+    for(size_t i = 0; i < results.size(); i++) {
+        const bench_result &r = results[i];
+        os << "    {\"name\": " << jsonString(r.name) << ", \"mips\": " << r.mips
+           << ", \"ns_per_instruction\": " << r.nsPerInstruction << ", \"drw_per_second\": " << r.drawsPerSecond
+           << ", \"drw_share\": " << r.drawShare << ", \"peak_rss_kb\": " << r.peakRssKb
+           << ", \"hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << r.hash << std::dec
+           << std::setfill(' ') << "\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char **argv) {
+    uint64_t cycles = 10000000;
+    int repeat = 3;
+    std::string jsonPath;
+    std::string romDirectory = "c8games";
+    for(int i = 1; i < argc; i++) {
+        if(std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = std::strtoull(argv[++i], nullptr, 10);
+        } else if(std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if(argv[i][0] != '-') {
+            romDirectory = argv[i];
+        } else {
+            std::cerr << "usage: yac8-bench [--cycles N] [--repeat N] [--json results.json] [rom directory]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::vector<char>>> roms;
+    roms.emplace_back("DEMO_ROM", std::vector<char>((const char *) DEMO_ROM, (const char *) DEMO_ROM + sizeof(DEMO_ROM)));
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for(const auto &entry : std::filesystem::directory_iterator(romDirectory, error)) {
+        if(entry.is_regular_file() && entry.file_size() <= RAM_SIZE - PROGRAM_OFFSET - 1)
+            paths.push_back(entry.path());
+    }
+    if(error)
+        std::cerr << "Could not read " << romDirectory << ": " << error.message() << std::endl;
+    std::sort(paths.begin(), paths.end());
+    for(const std::filesystem::path &path : paths) {
+        std::ifstream is(path, std::ios::in | std::ios::binary);
+        roms.emplace_back(path.filename().string(),
+                          std::vector<char>((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()));
+    }
+
+    std::vector<bench_result> results;
+    std::cout << std::left << std::setw(16) << "rom" << std::right << std::setw(10) << "MIPS" << std::setw(10) << "ns/inst"
+              << std::setw(12) << "DRW/s" << std::setw(10) << "RSS KB" << "  hash" << std::endl;
+    for(const auto &rom : roms) {
+        bench_result r = bench(rom.first, rom.second, cycles, repeat);
+        results.push_back(r);
+        std::cout << std::left << std::setw(16) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << r.mips << std::setprecision(2) << std::setw(10) << r.nsPerInstruction
+                  << std::setprecision(0) << std::setw(12) << r.drawsPerSecond << std::setw(10) << r.peakRssKb
+                  << "  " << std::hex << std::setw(16) << std::setfill('0') << r.hash << std::dec << std::setfill(' ')
+                  << std::endl;
+    }
+
+    double totalSeconds = 0;
+    for(const bench_result &r : results) {
+        totalSeconds += cycles / (r.mips * 1e6);
+    }
+    std::cout << "overall: " << std::setprecision(1) << results.size() * cycles / totalSeconds / 1e6 << " MIPS" << std::endl;
+
+    if(!jsonPath.empty() && !writeJSON(jsonPath, results, cycles, repeat)) {
+        std::cerr << "Could not write " << jsonPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,441 @@
+/**
+ * Runs the reference interpreter (c8_state) and a candidate backend in lockstep and reports the first divergence:
+ *
+ *     yac8-difftest [--candidate paged] [--cycles N] [--every N] [--random N] [--seed S] [rom directory]
+ *
+ * Both backends start from the same RAM image, random seed, quirks and scripted input. Every `every` instructions
+ * their registers, RAM and framebuffers are compared. On a mismatch both are rolled back to the last matching
+ * checkpoint and replayed one instruction at a time, so the report names the exact instruction that diverged.
+ * Every ROM in the directory (c8games by default) is checked, followed by `random` generated programs.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "c8_debug.hpp"
+#include "c8_demo_rom.hpp"
+#include "c8_display.hpp"
+#include "c8_input_script.hpp"
+#include "c8_paged_ram.hpp"
+#include "c8_state.hpp"
+
+using namespace yac8;
+
+const int PROCESSOR_SPEED = 1000;
+const uint64_t RANDOM_PROGRAM_CYCLES = 20000;
+const int RANDOM_PROGRAM_SIZE = 0x200;
+// a divergence report lists at most this many differing fields
+const int MAX_REPORTED_DIFFERENCES = 16;
+
+/**
+ * One way of executing Chip-8 instructions, with its own framebuffer and random generator.
+ * Timers and input belong to the harness, which applies them to both backends identically.
+ */
+class lockstep_backend {
+public:
+    c8_display display{};
+    std::mt19937 rng{};
+    c8_quirks quirks{};
+
+    virtual ~lockstep_backend() = default;
+    virtual c8_registers &registers() = 0;
+    virtual void load(const c8_state &state) = 0;
+    virtual void store(c8_state &state) const = 0;
+    virtual bool step() = 0;
+};
+
+static void loadState(c8_state &backend, const c8_state &state) { backend = state; }
+static void loadState(c8_paged_state &backend, const c8_state &state) { backend = c8_paged_state(state); }
+static void storeState(const c8_state &backend, c8_state &state) { state = backend; }
+static void storeState(const c8_paged_state &backend, c8_state &state) { backend.store(state); }
+
+// any state class with c8_state's step() signature, wired up the way c8_machine wires its own
+template<class State>
+class state_backend : public lockstep_backend {
+    State state;
+    c8_hardware_api hardware_api{};
+public:
+    state_backend() {
+        hardware_api.draw_sprite = [this](const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t planes, uint8_t &VF) {
+            display.drawSprite(sprite, x, y, n, planes, VF, quirks.wrap);
+        };
+        hardware_api.clear_screen = [this](uint8_t planes) { display.clear(planes); };
+        hardware_api.scroll_screen = [this](int dx, int dy, uint8_t planes) { display.scroll(dx, dy, planes); };
+        hardware_api.set_resolution = [this](bool hires) { display.setHires(hires); };
+        hardware_api.random_byte = [this]()->uint8_t { return (uint8_t)(rng() >> 24); };
+    }
+
+    c8_registers &registers() override { return state; }
+    void load(const c8_state &s) override { loadState(state, s); }
+    void store(c8_state &s) const override { storeState(state, s); }
+    bool step() override { return state.step(hardware_api, quirks); }
+};
+
+// new backends register here to become selectable with --candidate
+static std::unique_ptr<lockstep_backend> makeBackend(const std::string &name) {
+    if(name == "reference")
+        return std::make_unique<state_backend<c8_state>>();
+    if(name == "paged")
+        return std::make_unique<state_backend<c8_paged_state>>();
+    return nullptr;
+}
+
+/**
+ * The two backends driven as one machine: input, timers and guest time are applied to both.
+ */
+struct lockstep_pair {
+    lockstep_backend &reference;
+    lockstep_backend &candidate;
+    uint64_t cycle = 0;
+    int timerPhase = 0;
+    c8_input_script script;
+
+    lockstep_pair(lockstep_backend &reference, lockstep_backend &candidate, uint32_t seed)
+            : reference(reference), candidate(candidate), script(seed) {}
+
+    void press(uint8_t key) {
+        for(lockstep_backend *backend : {&reference, &candidate}) {
+            c8_registers &r = backend->registers();
+            if(r.lastKey == NO_LAST_KEY)
+                r.lastKey = key;
+            r.keyStates[key] = true;
+        }
+    }
+
+    void release(uint8_t key) {
+        reference.registers().keyStates[key] = false;
+        candidate.registers().keyStates[key] = false;
+    }
+
+    // same guest time as c8_machine: input at the start of each frame, timers at 60Hz. False if the
+    // backends disagreed on whether the instruction was valid
+    bool step() {
+        if(cycle % (PROCESSOR_SPEED / TIMER_FREQUENCY) == 0)
+            script.frame(*this);
+        bool agreed = reference.step() == candidate.step();
+        cycle++;
+        timerPhase += TIMER_FREQUENCY;
+        if(timerPhase >= PROCESSOR_SPEED) {
+            timerPhase -= PROCESSOR_SPEED;
+            for(lockstep_backend *backend : {&reference, &candidate}) {
+                c8_registers &r = backend->registers();
+                if(r.dt != 0)
+                    r.dt -= 1;
+                if(r.st != 0)
+                    r.st -= 1;
+                r.lastKey = NO_LAST_KEY;
+            }
+        }
+        return agreed;
+    }
+};
+
+/**
+ * Everything needed to roll a lockstep_pair back to the last point where both backends agreed.
+ */
+struct lockstep_checkpoint {
+    c8_state state;
+    c8_display display;
+    std::mt19937 referenceRng, candidateRng;
+    c8_input_script script{0};
+    uint64_t cycle = 0;
+    int timerPhase = 0;
+
+    void save(const lockstep_pair &pair) {
+        pair.reference.store(state);
+        display = pair.reference.display;
+        referenceRng = pair.reference.rng;
+        candidateRng = pair.candidate.rng;
+        script = pair.script;
+        cycle = pair.cycle;
+        timerPhase = pair.timerPhase;
+    }
+
+    // both backends agreed when the checkpoint was saved, so both are restored from the reference's copy
+    void restore(lockstep_pair &pair) const {
+        pair.reference.load(state);
+        pair.candidate.load(state);
+        pair.reference.display = display;
+        pair.candidate.display = display;
+        pair.reference.rng = referenceRng;
+        pair.candidate.rng = candidateRng;
+        pair.script = script;
+        pair.cycle = cycle;
+        pair.timerPhase = timerPhase;
+    }
+};
+
+static std::string hex(uint32_t value, int digits) {
+    std::ostringstream ss;
+    ss << "0x" << std::hex << std::uppercase << std::setw(digits) << std::setfill('0') << value;
+    return ss.str();
+}
+
+// every guest-visible difference between the two machines, up to MAX_REPORTED_DIFFERENCES
+static std::vector<std::string> compare(const c8_state &a, const c8_display &da, const c8_state &b, const c8_display &db) {
+    std::vector<std::string> differences;
+    auto differ = [&](const std::string &what, int x, int y, int digits) {
+        if(differences.size() < MAX_REPORTED_DIFFERENCES)
+            differences.push_back(what + ": reference " + hex(x, digits) + ", candidate " + hex(y, digits));
+    };
+    if(a.pc != b.pc)
+        differ("PC", a.pc, b.pc, 3);
+    if(a.sp != b.sp)
+        differ("SP", a.sp, b.sp, 1);
+    for(int i = 0; i < STACK_SIZE; i++) {
+        if(a.stack[i] != b.stack[i])
+            differ("stack[" + std::to_string(i) + "]", a.stack[i], b.stack[i], 3);
+    }
+    for(int i = 0; i < V_REGISTERS_SIZE; i++) {
+        if(a.v[i] != b.v[i])
+            differ(hex(i, 1).replace(0, 2, "V"), a.v[i], b.v[i], 2);
+    }
+    if(a.I != b.I)
+        differ("I", a.I, b.I, 3);
+    if(a.dt != b.dt)
+        differ("DT", a.dt, b.dt, 2);
+    if(a.st != b.st)
+        differ("ST", a.st, b.st, 2);
+    for(int i = 0; i < 16; i++) {
+        if(a.keyStates[i] != b.keyStates[i])
+            differ("key " + hex(i, 1), a.keyStates[i], b.keyStates[i], 1);
+    }
+    if(a.lastKey != b.lastKey)
+        differ("last key", a.lastKey, b.lastKey, 2);
+    for(int i = 0; i < RPL_FLAGS_SIZE; i++) {
+        if(a.rpl[i] != b.rpl[i])
+            differ("RPL[" + std::to_string(i) + "]", a.rpl[i], b.rpl[i], 2);
+    }
+    if(a.planes != b.planes)
+        differ("planes", a.planes, b.planes, 1);
+    for(int i = 0; i < AUDIO_PATTERN_SIZE; i++) {
+        if(a.audioPattern[i] != b.audioPattern[i])
+            differ("audio pattern[" + std::to_string(i) + "]", a.audioPattern[i], b.audioPattern[i], 2);
+    }
+    if(a.pitch != b.pitch)
+        differ("pitch", a.pitch, b.pitch, 2);
+    if(a.audioPatternLoaded != b.audioPatternLoaded)
+        differ("audio pattern loaded", a.audioPatternLoaded, b.audioPatternLoaded, 1);
+    if(a.faults != b.faults)
+        differ("faults", a.faults, b.faults, 2);
+    // RAM and the framebuffer are compared wholesale first, they almost always match
+    if(std::memcmp(a.ram, b.ram, sizeof(a.ram)) != 0) {
+        for(int addr = 0; addr < RAM_SIZE; addr++) {
+            if(a.ram[addr] != b.ram[addr])
+                differ("RAM[" + hex(addr, 4) + "]", a.ram[addr], b.ram[addr], 2);
+        }
+    }
+    if(da.hires != db.hires) {
+        differ("hires", da.hires, db.hires, 1);
+    } else if(std::memcmp(da.rows, db.rows, sizeof(da.rows)) != 0) {
+        for(int y = 0; y < da.height(); y++) {
+            for(int x = 0; x < da.width(); x++) {
+                if(da.pixel(x, y) != db.pixel(x, y))
+                    differ("pixel (" + std::to_string(x) + ", " + std::to_string(y) + ")",
+                           da.pixel(x, y), db.pixel(x, y), 1);
+            }
+        }
+    }
+    return differences;
+}
+
+/**
+ * Runs `rom` on both backends for `cycles` instructions. Returns true if they never diverged, otherwise prints
+ * a report of the first divergence to `report`.
+ */
+static bool lockstep(const std::vector<uint8_t> &rom, const std::string &candidateName, c8_quirks quirks,
+                     uint32_t seed, uint64_t cycles, uint64_t every, std::ostream &report) {
+    std::unique_ptr<lockstep_backend> reference = makeBackend("reference");
+    std::unique_ptr<lockstep_backend> candidate = makeBackend(candidateName);
+    c8_state initial{};
+    initial.loadROM(rom.data(), (int) rom.size());
+    for(lockstep_backend *backend : {reference.get(), candidate.get()}) {
+        backend->load(initial);
+        backend->quirks = quirks;
+        backend->rng.seed(seed);
+    }
+    lockstep_pair pair(*reference, *candidate, seed);
+
+    // reused across checks, c8_state is too large to copy around casually
+    auto checkpoint = std::make_unique<lockstep_checkpoint>();
+    auto a = std::make_unique<c8_state>();
+    auto b = std::make_unique<c8_state>();
+    checkpoint->save(pair);
+
+    auto diverged = [&]() {
+        reference->store(*a);
+        candidate->store(*b);
+        return !compare(*a, reference->display, *b, candidate->display).empty();
+    };
+
+    while(pair.cycle < cycles) {
+        bool agreed = pair.step();
+        if(agreed && pair.cycle % every != 0 && pair.cycle != cycles)
+            continue;
+        if(agreed && !diverged()) {
+            checkpoint->save(pair);
+            continue;
+        }
+
+        // replay from the last good checkpoint one instruction at a time to find the first bad one. The replay
+        // should diverge again by the cycle the divergence was detected at; if it doesn't, the run can't be bisected
+        uint64_t detected = pair.cycle;
+        checkpoint->restore(pair);
+        auto before = std::make_unique<c8_state>();
+        while(pair.cycle < detected) {
+            reference->store(*before);
+            uint64_t executed = pair.cycle;
+            agreed = pair.step();
+            if(agreed && !diverged())
+                continue;
+
+            uint16_t pc = before->pc;
+            report << "  diverged executing cycle " << executed << " at PC " << hex(pc, 3);
+            if(pc <= RAM_SIZE - 2)
+                report << ": " << hex(before->ram[pc] << 8 | before->ram[pc + 1], 4) << "  "
+                       << print_instruction(pc, *before, quirks);
+            report << "\n";
+            if(!agreed)
+                report << "    backends disagree on whether the instruction is valid\n";
+            reference->store(*a);
+            candidate->store(*b);
+            for(const std::string &difference : compare(*a, reference->display, *b, candidate->display)) {
+                report << "    " << difference << "\n";
+            }
+            return false;
+        }
+        report << "  diverged by cycle " << detected << ", but replaying from cycle " << checkpoint->cycle
+               << " did not reproduce it: the run is not deterministic\n";
+        return false;
+    }
+    return true;
+}
+
+// mostly well-formed instructions, so programs get past their first few words, with some raw words mixed in
+static std::vector<uint8_t> randomProgram(std::mt19937 &rng) {
+    static const uint8_t F_OPERATIONS[] = {0x01, 0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x30, 0x33, 0x3A, 0x55, 0x65,
+                                           0x75, 0x85};
+    // 00E0 and 00EE, then the SUPER-CHIP and XO-CHIP screen operations. 00FD is left out, it would end the program
+    static const uint16_t SYSTEM_OPERATIONS[] = {0x00E0, 0x00EE, 0x00C0, 0x00D0, 0x00FB, 0x00FC, 0x00FE, 0x00FF};
+    static const uint8_t ALU_OPERATIONS[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE};
+    std::vector<uint8_t> program(RANDOM_PROGRAM_SIZE);
+    for(int i = 0; i < RANDOM_PROGRAM_SIZE; i += 2) {
+        uint16_t word = rng() & 0xFFFF;
+        uint16_t x = word & 0x0F00;
+        uint16_t target = (PROGRAM_OFFSET + rng() % RANDOM_PROGRAM_SIZE) & ~1;
+        switch(rng() % 20) {
+            case 0:
+                word = SYSTEM_OPERATIONS[rng() % (sizeof(SYSTEM_OPERATIONS) / sizeof(SYSTEM_OPERATIONS[0]))];
+                // 00Cn and 00Dn take a scroll distance
+                if(word == 0x00C0 || word == 0x00D0)
+                    word |= rng() & 0xF;
+                break;
+            case 1: word = 0x1000 | target; break;
+            case 2: word = 0x2000 | target; break;
+            case 3: word = 0xB000 | target; break;
+            case 4: word = 0xA000 | (rng() % 0x1000); break;
+            case 5: word = 0x8000 | (word & 0x0FF0) | ALU_OPERATIONS[rng() % sizeof(ALU_OPERATIONS)]; break;
+            case 6: word = 0xE000 | x | ((rng() & 1) ? 0x9E : 0xA1); break;
+            case 7: word = 0xF000 | x | F_OPERATIONS[rng() % sizeof(F_OPERATIONS)]; break;
+            case 8: word = ((rng() & 1) ? 0x5000 : 0x9000) | (word & 0x0FF0); break;
+            // XO-CHIP: register ranges, and the audio pattern. F000 takes the following word as its address
+            case 10: word = 0x5000 | (word & 0x0FF0) | (2 + (rng() & 1)); break;
+            case 11: word = (rng() & 1) ? 0xF002 : 0xF000; break;
+            case 9: break;
+            default: word = (word & 0x0FFF) | (uint16_t)((3 + rng() % 11) << 12); break;
+        }
+        program[i] = word >> 8;
+        program[i + 1] = word & 0xFF;
+    }
+    return program;
+}
+
+int main(int argc, char **argv) {
+    std::string candidate = "paged";
+    uint64_t cycles = 1000000;
+    uint64_t every = 1000;
+    int randomPrograms = 200;
+    uint32_t seed = 0xC8;
+    std::string romDirectory = "c8games";
+    for(int i = 1; i < argc; i++) {
+        if(std::strcmp(argv[i], "--candidate") == 0 && i + 1 < argc) {
+            candidate = argv[++i];
+        } else if(std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = std::strtoull(argv[++i], nullptr, 10);
+        } else if(std::strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            every = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if(std::strcmp(argv[i], "--random") == 0 && i + 1 < argc) {
+            randomPrograms = std::max(0, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t) std::strtoul(argv[++i], nullptr, 0);
+        } else if(argv[i][0] != '-') {
+            romDirectory = argv[i];
+        } else {
+            std::cerr << "usage: yac8-difftest [--candidate paged] [--cycles N] [--every N] [--random N] [--seed S] "
+                         "[rom directory]" << std::endl;
+            return 1;
+        }
+    }
+    if(makeBackend(candidate) == nullptr) {
+        std::cerr << "Unknown backend " << candidate << std::endl;
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> roms;
+    roms.emplace_back("DEMO_ROM", std::vector<uint8_t>((const uint8_t *) DEMO_ROM,
+                                                       (const uint8_t *) DEMO_ROM + sizeof(DEMO_ROM)));
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for(const auto &entry : std::filesystem::directory_iterator(romDirectory, error)) {
+        if(entry.is_regular_file() && entry.file_size() <= RAM_SIZE - PROGRAM_OFFSET - 1)
+            paths.push_back(entry.path());
+    }
+    if(error)
+        std::cerr << "Could not read " << romDirectory << ": " << error.message() << std::endl;
+    std::sort(paths.begin(), paths.end());
+    for(const std::filesystem::path &path : paths) {
+        std::ifstream is(path, std::ios::in | std::ios::binary);
+        roms.emplace_back(path.filename().string(),
+                          std::vector<uint8_t>((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()));
+    }
+
+    int failures = 0;
+    for(const auto &rom : roms) {
+        std::ostringstream report;
+        bool passed = lockstep(rom.second, candidate, c8_quirks{}, seed, cycles, every, report);
+        std::cout << (passed ? "ok    " : "FAIL  ") << rom.first << std::endl << report.str();
+        failures += passed ? 0 : 1;
+    }
+
+    std::mt19937 generator(seed);
+    int randomFailures = 0;
+    for(int i = 0; i < randomPrograms; i++) {
+        uint32_t programSeed = generator();
+        std::mt19937 programRng(programSeed);
+        std::vector<uint8_t> program = randomProgram(programRng);
+        c8_quirks quirks = unpackQuirks(programRng() & 7);
+        std::ostringstream report;
+        if(!lockstep(program, candidate, quirks, programSeed, RANDOM_PROGRAM_CYCLES, every, report)) {
+            std::cout << "FAIL  random program, seed " << hex(programSeed, 8) << ", quirks "
+                      << packQuirks(quirks) << std::endl << report.str();
+            randomFailures++;
+        }
+    }
+    if(randomPrograms > 0)
+        std::cout << (randomPrograms - randomFailures) << "/" << randomPrograms << " random programs ok" << std::endl;
+
+    failures += randomFailures;
+    std::cout << (failures == 0 ? "no divergences" : std::to_string(failures) + " divergent run(s)") << " between "
+              << "reference and " << candidate << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/**
+ * Coverage-guided fuzz target for the interpreter. Built with -DYAC8_FUZZ=ON; under clang it links libFuzzer:
+ *
+ *     yac8-fuzz [libFuzzer options] [corpus directory]
+ *
+ * Other compilers get a standalone driver instead, which replays the given input files, or times a batch of random
+ * inputs when given none:
+ *
+ *     yac8-fuzz [input files]
+ *
+ * An input is a quirk byte, a big-endian ROM length and the ROM itself, followed by an input schedule of (frames to
+ * wait, key event) byte pairs; bit 7 of a key event means press, its low nibble is the key. Every execution starts from
+ * a pristine snapshot, rather than reconstructing the machine, and only the RAM pages the previous execution dirtied
+ * are copied back. Each instruction's faults are checked against an independent statement of when the core must refuse
+ * one (PC outside of RAM, or an XO-CHIP long address past its end, stack over/underflow, memory accesses at I past the
+ * end of RAM), and any disagreement aborts. Anything worse is left to the address and undefined behaviour sanitizers
+ * the target is built with.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "c8_machine.hpp"
+#include "c8_opcodes.hpp"
+
+#ifndef YAC8_LIBFUZZER
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+#endif
+
+using namespace yac8;
+
+// guest cycles per execution: a ROM's setup and the start of its main loop. Much more and each execution costs
+// more than the coverage it tends to add
+const uint64_t FUZZ_CYCLES = 256;
+// 4 cycles per frame, so that timer waits and the input schedule play out within FUZZ_CYCLES
+const int FUZZ_PROCESSOR_SPEED = 4 * TIMER_FREQUENCY;
+const size_t HEADER_SIZE = 3;
+
+// the c8_fault bits executing `instruction` must raise. Decoding is shared with the core through classifyOpcode,
+// the conditions are restated here from the spec rather than taken from c8_state
+static uint8_t requiredFaults(const c8_registers &r, uint16_t instruction) {
+    uint8_t x = (instruction >> 8) & 0xF, y = (instruction >> 4) & 0xF;
+    int planes = (r.planes & 1) + (r.planes >> 1 & 1);
+    switch(classifyOpcode(instruction)) {
+        case OP_RET: return r.sp == 0 ? FAULT_STACK_UNDERFLOW : 0;
+        case OP_CALL: return r.sp == STACK_SIZE ? FAULT_STACK_OVERFLOW : 0;
+        case OP_DRW:
+            return r.I + ((instruction & 0xF) == 0 ? 32 : (instruction & 0xF)) * planes > RAM_SIZE ? FAULT_I_OUT_OF_RANGE : 0;
+        case OP_LD_B: return r.I + 3 > RAM_SIZE ? FAULT_I_OUT_OF_RANGE : 0;
+        case OP_LD_MEM_VX:
+        case OP_LD_VX_MEM: return r.I + x + 1 > RAM_SIZE ? FAULT_I_OUT_OF_RANGE : 0;
+        case OP_SAVE_RANGE:
+        case OP_LOAD_RANGE: return r.I + std::abs(x - y) + 1 > RAM_SIZE ? FAULT_I_OUT_OF_RANGE : 0;
+        case OP_AUDIO: return r.I + AUDIO_PATTERN_SIZE > RAM_SIZE ? FAULT_I_OUT_OF_RANGE : 0;
+        case OP_LD_I_LONG: return r.pc + 4 > RAM_SIZE ? FAULT_PC_OUT_OF_RANGE : 0;
+        default: return 0;
+    }
+}
+
+// aborts, so that the fuzzer keeps the input, when the core's bookkeeping disagrees with requiredFaults
+static void check(bool condition) {
+    if(!condition)
+        std::abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static c8_machine machine;
+    static c8_machine_snapshot pristine;
+    // the machine's page write counts as of the last time its RAM matched pristine's
+    static uint32_t pristineWrites[PAGE_COUNT];
+    static bool initialized = false;
+    if(!initialized) {
+        machine.reset(nullptr, 0, 0);
+        machine.processorSpeed = FUZZ_PROCESSOR_SPEED;
+        machine.save(pristine);
+        std::memcpy(pristineWrites, machine.state.pageWrites, sizeof(pristineWrites));
+        initialized = true;
+    }
+    if(size < HEADER_SIZE)
+        return 0;
+
+    machine.restoreWritten(pristine, pristineWrites);
+    machine.quirks = unpackQuirks(data[0] & 7);
+    size_t romSize = std::min<size_t>({(size_t) (data[1] << 8 | data[2]), size - HEADER_SIZE,
+                                       (size_t) (RAM_SIZE - PROGRAM_OFFSET)});
+    std::memcpy(machine.state.ram + PROGRAM_OFFSET, data + HEADER_SIZE, romSize);
+    // the ROM bypasses c8_state::write(), so its pages are marked by hand for the next restore
+    for(size_t p = PROGRAM_OFFSET / PAGE_SIZE; p * PAGE_SIZE < PROGRAM_OFFSET + romSize; p++) {
+        machine.state.pageWrites[p]++;
+    }
+    const uint8_t *schedule = data + HEADER_SIZE + romSize;
+    const uint8_t *scheduleEnd = data + size;
+
+    const uint64_t cyclesPerFrame = std::max(1, machine.processorSpeed / TIMER_FREQUENCY);
+    uint64_t nextEvent = schedule + 1 < scheduleEnd ? (schedule[0] % 16) * cyclesPerFrame : UINT64_MAX;
+    while(machine.cycle < FUZZ_CYCLES) {
+        while(machine.cycle >= nextEvent) {
+            uint8_t event = schedule[1];
+            if(event & 0x80)
+                machine.press(event & 0xF);
+            else
+                machine.release(event & 0xF);
+            schedule += 2;
+            nextEvent = schedule + 1 < scheduleEnd ? nextEvent + (schedule[0] % 16) * cyclesPerFrame : UINT64_MAX;
+        }
+
+        const c8_state &state = machine.state;
+        uint16_t pc = state.pc;
+        uint8_t faultsBefore = state.faults;
+        if(pc < PROGRAM_OFFSET || pc > RAM_SIZE - 2) {
+            machine.step();
+            check(state.faults & FAULT_PC_OUT_OF_RANGE);
+            // the machine is stuck until reset
+            break;
+        }
+
+        uint16_t instruction = (uint16_t) (state.ram[pc] << 8 | state.ram[pc + 1]);
+        uint8_t required = requiredFaults(state, instruction);
+        machine.step();
+        uint8_t raised = state.faults & ~faultsBefore;
+        check((state.faults & required) == required);
+        check((raised & ~required) == 0);
+        check(state.sp <= STACK_SIZE);
+
+        // a jump to itself, or 00FD, can never do anything else
+        if(((instruction & 0xF000) == 0x1000 && (instruction & 0x0FFF) == pc) || instruction == 0x00FD)
+            break;
+    }
+    return 0;
+}
+
+#ifndef YAC8_LIBFUZZER
+int main(int argc, char **argv) {
+    if(argc > 1) {
+        for(int i = 1; i < argc; i++) {
+            std::ifstream is(argv[i], std::ios::in | std::ios::binary);
+            std::vector<uint8_t> input((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+            std::cout << "ok  " << argv[i] << std::endl;
+        }
+        return 0;
+    }
+
+    // no inputs: measure throughput on random ones, generated up front so that only executions are timed
+    const int executions = 100000, distinct = 4096;
+    std::mt19937 rng(0xC8);
+    std::vector<std::vector<uint8_t>> inputs(distinct);
+    for(std::vector<uint8_t> &input : inputs) {
+        input.resize(HEADER_SIZE + rng() % 512);
+        for(uint8_t &byte : input) {
+            byte = (uint8_t) rng();
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < executions; i++) {
+        const std::vector<uint8_t> &input = inputs[i % distinct];
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << executions << " random inputs, " << (int) (executions / seconds) << " exec/s" << std::endl;
+    return 0;
+}
+#endif
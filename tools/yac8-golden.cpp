@@ -0,0 +1,230 @@
+/**
+ * Checks the framebuffer (and XO-CHIP sound) of every bundled ROM against checked-in golden hashes:
+ *
+ *     yac8-golden [--update] [--jobs N] [--golden tools/golden_hashes.txt] [rom directory]
+ *
+ * Each ROM in the directory (c8games by default), plus the built-in demo and the self-checking test ROMs in
+ * golden_test_roms.hpp, boots headless under every quirk combination with the same seed and scripted input, and the
+ * framebuffer is hashed at the end of a few chosen guest frames. Any hash that differs from the golden file is
+ * reported, and the exit code is non-zero. ROMs run in parallel on `jobs` threads. `--update` rewrites the golden file
+ * from the current core instead, for when a change to the output is intended.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "c8_demo_rom.hpp"
+#include "c8_hash.hpp"
+#include "c8_input_script.hpp"
+#include "c8_machine.hpp"
+#include "golden_test_roms.hpp"
+
+using namespace yac8;
+
+const uint32_t GOLDEN_SEED = 0xC8;
+// guest frames after which the framebuffer is hashed: boot, title screen, early and later gameplay
+const int GOLDEN_FRAMES[] = {10, 60, 300, 1200};
+const int GOLDEN_FRAME_COUNT = sizeof(GOLDEN_FRAMES) / sizeof(GOLDEN_FRAMES[0]);
+const int QUIRK_COMBINATIONS = 8;
+
+struct golden_run {
+    std::string name;
+    const std::vector<char> *rom = nullptr;
+    uint16_t quirks = 0;
+    uint64_t hashes[GOLDEN_FRAME_COUNT] = {0};
+
+    std::string key() const { return name + " " + std::to_string(quirks); }
+};
+
+// what the program shows, and the XO-CHIP sound it plays once it has loaded one. Programs that never do hash
+// their framebuffer alone
+static uint64_t observe(const c8_machine &machine) {
+    uint64_t h = machine.display.hash();
+    if(machine.state.audioPatternLoaded) {
+        h = fnv1a(machine.state.audioPattern, sizeof(machine.state.audioPattern), h);
+        h = fnv1a(&machine.state.pitch, sizeof(machine.state.pitch), h);
+    }
+    return h;
+}
+
+static void run(golden_run &r, c8_machine &machine) {
+    machine.quirks = unpackQuirks(r.quirks);
+    machine.reset((const uint8_t *) r.rom->data(), (int) r.rom->size(), GOLDEN_SEED);
+    c8_input_script script(GOLDEN_SEED);
+    const uint64_t cyclesPerFrame = std::max(1, machine.processorSpeed / TIMER_FREQUENCY);
+    int next = 0;
+    for(int frame = 1; next < GOLDEN_FRAME_COUNT; frame++) {
+        script.frame(machine);
+        for(uint64_t i = 0; i < cyclesPerFrame; i++) {
+            machine.step();
+        }
+        if(frame == GOLDEN_FRAMES[next])
+            r.hashes[next++] = observe(machine);
+    }
+}
+
+static std::string hex(uint64_t hash) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
+
+// "NAME QUIRKS HASH HASH ..." per line, one hash per GOLDEN_FRAMES entry. Lines starting with # are comments
+static std::map<std::string, std::vector<std::string>> readGolden(const std::string &path) {
+    std::map<std::string, std::vector<std::string>> golden;
+    std::ifstream is(path);
+    std::string line;
+    while(std::getline(is, line)) {
+        if(line.empty() || line[0] == '#')
+            continue;
+        std::istringstream ss(line);
+        std::string name, quirks, hash;
+        ss >> name >> quirks;
+        std::vector<std::string> &hashes = golden[name + " " + quirks];
+        while(ss >> hash) {
+            hashes.push_back(hash);
+        }
+    }
+    return golden;
+}
+
+static bool writeGolden(const std::string &path, const std::vector<golden_run> &runs) {
+    std::ofstream os(path, std::ios::out | std::ios::trunc);
+    if(!os.is_open())
+        return false;
+    os << "# Framebuffer hashes for yac8-golden. Regenerate with yac8-golden --update after an intended change\n";
+    os << "# rom, packed quirks, then FNV-1a of the framebuffer after guest frames";
+    for(int frame : GOLDEN_FRAMES) {
+        os << " " << frame;
+    }
+    os << "\n";
+    for(const golden_run &r : runs) {
+        os << r.key();
+        for(uint64_t hash : r.hashes) {
+            os << " " << hex(hash);
+        }
+        os << "\n";
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool update = false;
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string goldenPath = "tools/golden_hashes.txt";
+    std::string romDirectory = "c8games";
+    for(int i = 1; i < argc; i++) {
+        if(std::strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if(std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            goldenPath = argv[++i];
+        } else if(argv[i][0] != '-') {
+            romDirectory = argv[i];
+        } else {
+            std::cerr << "usage: yac8-golden [--update] [--jobs N] [--golden tools/golden_hashes.txt] [rom directory]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::vector<char>>> roms;
+    roms.emplace_back("DEMO_ROM", std::vector<char>((const char *) DEMO_ROM, (const char *) DEMO_ROM + sizeof(DEMO_ROM)));
+    roms.emplace_back("SCHIP_TEST_ROM", std::vector<char>((const char *) SCHIP_TEST_ROM,
+                                                          (const char *) SCHIP_TEST_ROM + sizeof(SCHIP_TEST_ROM)));
+    roms.emplace_back("XO_CHIP_TEST_ROM", std::vector<char>((const char *) XO_CHIP_TEST_ROM,
+                                                            (const char *) XO_CHIP_TEST_ROM + sizeof(XO_CHIP_TEST_ROM)));
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for(const auto &entry : std::filesystem::directory_iterator(romDirectory, error)) {
+        if(entry.is_regular_file() && entry.file_size() <= RAM_SIZE - PROGRAM_OFFSET - 1)
+            paths.push_back(entry.path());
+    }
+    if(error)
+        std::cerr << "Could not read " << romDirectory << ": " << error.message() << std::endl;
+    std::sort(paths.begin(), paths.end());
+    for(const std::filesystem::path &path : paths) {
+        std::ifstream is(path, std::ios::in | std::ios::binary);
+        roms.emplace_back(path.filename().string(),
+                          std::vector<char>((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()));
+    }
+
+    std::vector<golden_run> runs;
+    for(const auto &rom : roms) {
+        for(uint16_t quirks = 0; quirks < QUIRK_COMBINATIONS; quirks++) {
+            golden_run r;
+            r.name = rom.first;
+            r.rom = &rom.second;
+            r.quirks = quirks;
+            runs.push_back(r);
+        }
+    }
+
+    // every run is independent, so workers just take the next one until none are left
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for(int i = 0; i < jobs; i++) {
+        workers.emplace_back([&]() {
+            c8_machine machine;
+            for(size_t r = next++; r < runs.size(); r = next++) {
+                run(runs[r], machine);
+            }
+        });
+    }
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(update) {
+        if(!writeGolden(goldenPath, runs)) {
+            std::cerr << "Could not write " << goldenPath << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << runs.size() << " runs to " << goldenPath << std::endl;
+        return 0;
+    }
+
+    std::map<std::string, std::vector<std::string>> golden = readGolden(goldenPath);
+    if(golden.empty()) {
+        std::cerr << "No golden hashes in " << goldenPath << ", run with --update to create them" << std::endl;
+        return 1;
+    }
+    int failures = 0;
+    for(const golden_run &r : runs) {
+        auto expected = golden.find(r.key());
+        if(expected == golden.end()) {
+            std::cout << "NEW   " << r.key() << ": no golden hashes" << std::endl;
+            failures++;
+            continue;
+        }
+        for(int f = 0; f < GOLDEN_FRAME_COUNT; f++) {
+            std::string actual = hex(r.hashes[f]);
+            if(f >= (int) expected->second.size() || expected->second[f] != actual) {
+                std::cout << "FAIL  " << r.name << " quirks " << r.quirks << " frame " << GOLDEN_FRAMES[f]
+                          << ": expected " << (f < (int) expected->second.size() ? expected->second[f] : "nothing")
+                          << ", got " << actual << std::endl;
+                failures++;
+                // later frames almost always follow the first mismatch
+                break;
+            }
+        }
+    }
+    std::cout << runs.size() - failures << "/" << runs.size() << " runs match in " << std::fixed
+              << std::setprecision(2) << seconds << "s on " << jobs << " thread(s)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+/**
+ * Times the interpreter's hot kernels in isolation:
+ *
+ *     yac8-microbench [--samples N] [--min-time ms] [--filter substring] [--json results.json]
+ *
+ * Each kernel is warmed up, then a batch size is picked so that one sample takes at least `min-time`. `samples`
+ * batches are timed and reported as ns per operation: the median, the mean with its 95% confidence interval, and
+ * the relative spread, so a regression can be told apart from noise before trusting a yac8-bench number.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "c8_debug.hpp"
+#include "c8_demo_rom.hpp"
+#include "c8_display.hpp"
+#include "c8_machine.hpp"
+#include "c8_opcodes.hpp"
+#include "c8_state.hpp"
+
+using namespace yac8;
+
+// keeps the optimizer from discarding a result that nothing else reads
+template<class T>
+static void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+struct microbench_result {
+    std::string name;
+    uint64_t batch = 0;
+    double median = 0;
+    double mean = 0;
+    double ci95 = 0;
+    double relativeStdDev = 0;
+};
+
+// two-sided 95% Student t critical values for 1..30 degrees of freedom, the normal value beyond that
+static double tCritical(int degreesOfFreedom) {
+    static const double TABLE[30] = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+            2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+            2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if(degreesOfFreedom < 1)
+        return 0;
+    return degreesOfFreedom <= 30 ? TABLE[degreesOfFreedom - 1] : 1.960;
+}
+
+/**
+ * Runs one kernel: `op` performs a single operation and is called `batch` times per sample.
+ */
+static microbench_result measure(const std::string &name, const std::function<void()> &op, int samples,
+                                 double minSeconds) {
+    using clock = std::chrono::steady_clock;
+    auto time = [&](uint64_t batch) {
+        auto start = clock::now();
+        for(uint64_t i = 0; i < batch; i++) {
+            op();
+        }
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    // warm caches and branch predictors, and grow the batch until one sample is long enough to time reliably
+    uint64_t batch = 1;
+    double seconds = time(batch);
+    while(seconds < minSeconds) {
+        batch *= seconds > 0 ? std::max<uint64_t>(2, std::min<uint64_t>(100, (uint64_t) (minSeconds / seconds) + 1)) : 100;
+        seconds = time(batch);
+    }
+    time(batch);
+
+    std::vector<double> ns(samples);
+    for(int i = 0; i < samples; i++) {
+        ns[i] = time(batch) * 1e9 / batch;
+    }
+
+    microbench_result result;
+    result.name = name;
+    result.batch = batch;
+    for(double x : ns) {
+        result.mean += x;
+    }
+    result.mean /= samples;
+    double variance = 0;
+    for(double x : ns) {
+        variance += (x - result.mean) * (x - result.mean);
+    }
+    double stdDev = samples > 1 ? std::sqrt(variance / (samples - 1)) : 0;
+    result.ci95 = tCritical(samples - 1) * stdDev / std::sqrt((double) samples);
+    result.relativeStdDev = result.mean > 0 ? stdDev / result.mean : 0;
+    std::sort(ns.begin(), ns.end());
+    result.median = samples % 2 ? ns[samples / 2] : (ns[samples / 2 - 1] + ns[samples / 2]) / 2;
+    return result;
+}
+
+/**
+ * A c8_state running a program made of one instruction repeated, wired to a display and generator the way
+ * c8_machine wires its own. Registers are nudged back into range between steps, so skips, calls, returns and
+ * I arithmetic can run forever without faulting.
+ */
+struct step_kernel {
+    // the program fills [PROGRAM_OFFSET, DATA_OFFSET). I points past it, so Fx33/Fx55 can't overwrite it
+    static const uint16_t DATA_OFFSET = 0x300;
+
+    c8_state state;
+    c8_display display;
+    std::mt19937 rng;
+    c8_hardware_api api;
+    c8_quirks quirks{};
+
+    explicit step_kernel(uint16_t instruction) {
+        api.draw_sprite = [this](const uint8_t *sprite, uint8_t x, uint8_t y, uint8_t n, uint8_t planes, uint8_t &VF) {
+            display.drawSprite(sprite, x, y, n, planes, VF, quirks.wrap);
+        };
+        api.clear_screen = [this](uint8_t planes) { display.clear(planes); };
+        api.scroll_screen = [this](int dx, int dy, uint8_t planes) { display.scroll(dx, dy, planes); };
+        api.set_resolution = [this](bool hires) { display.setHires(hires); };
+        api.random_byte = [this]()->uint8_t { return (uint8_t)(rng() >> 24); };
+
+        state.loadTypography(default_typography_buffer);
+        for(int addr = PROGRAM_OFFSET; addr < DATA_OFFSET; addr += 2) {
+            state.ram[addr] = instruction >> 8;
+            state.ram[addr + 1] = instruction & 0xFF;
+        }
+        for(int i = 0; i < STACK_SIZE; i++) {
+            state.stack[i] = PROGRAM_OFFSET;
+        }
+        for(int i = 0; i < V_REGISTERS_SIZE; i++) {
+            state.v[i] = 0x12 + i;
+        }
+        state.sp = 1;
+        state.I = DATA_OFFSET;
+    }
+
+    void operator()() {
+        if(state.pc < PROGRAM_OFFSET || state.pc >= DATA_OFFSET)
+            state.pc = PROGRAM_OFFSET;
+        if(state.sp == 0 || state.sp == STACK_SIZE)
+            state.sp = 1;
+        if(state.I >= RAM_SIZE - 0x100)
+            state.I = DATA_OFFSET;
+        state.step(api, quirks);
+        keep(state.v);
+    }
+};
+
+// one representative encoding per opcode class
+static const uint16_t STEP_INSTRUCTIONS[] = {
+        0x0123, 0x00E0, 0x00EE, 0x1200, 0x2200, 0x3012, 0x4012, 0x5120, 0x6012, 0x7012,
+        0x8120, 0x8121, 0x8122, 0x8123, 0x8124, 0x8125, 0x8126, 0x8127, 0x812E, 0x9120,
+        0xA300, 0xB200, 0xC1FF, 0xD125, 0xE19E, 0xE1A1, 0xF107, 0xF10A, 0xF115, 0xF118,
+        0xF11E, 0xF129, 0xF133, 0xF155, 0xF165, 0x00C4, 0x00FB, 0x00FC, 0x00FF, 0xD120, 0xF130,
+        0xF175, 0xF185, 0x00D4, 0x5122, 0x5123, 0xF000, 0xF301, 0xF002, 0xF13A, 0xFFFF
+};
+
+static bool writeJSON(const std::string &path, const std::vector<microbench_result> &results, int samples) {
+    std::ofstream os(path, std::ios::out | std::ios::trunc);
+    if(!os.is_open())
+        return false;
+    os << "{\n  \"samples\": " << samples << ",\n  \"kernels\": [\n";
+    for(size_t i = 0; i < results.size(); i++) {
+        const microbench_result &r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"batch\": " << r.batch << ", \"median_ns\": " << r.median
+           << ", \"mean_ns\": " << r.mean << ", \"ci95_ns\": " << r.ci95 << ", \"rsd\": " << r.relativeStdDev
+           << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int samples = 20;
+    double minSeconds = 0.01;
+    std::string filter;
+    std::string jsonPath;
+    for(int i = 1; i < argc; i++) {
+        if(std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = std::max(2, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minSeconds = std::max(0.001, std::atof(argv[++i]) / 1000);
+        } else if(std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "usage: yac8-microbench [--samples N] [--min-time ms] [--filter substring] [--json results.json]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::function<void()>>> kernels;
+
+    for(uint16_t instruction : STEP_INSTRUCTIONS) {
+        auto kernel = std::make_shared<step_kernel>(instruction);
+        // the encoding tells apart instructions of the same kind, like a 5 and a 16 row DRW
+        char encoding[8];
+        std::snprintf(encoding, sizeof(encoding), " (%04X)", instruction);
+        kernels.emplace_back(std::string("step/") + OPCODE_NAMES[classifyOpcode(instruction)] + encoding,
+                             [kernel]() { (*kernel)(); });
+    }
+
+    // a full-height sprite, the worst case Dxyn can draw
+    static const uint8_t SPRITE[15] = {0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x3C, 0x42, 0x99, 0xA5, 0x99, 0x42, 0x3C};
+    struct sprite_case { const char *name; uint8_t x, y; bool wrap; };
+    static const sprite_case SPRITE_CASES[] = {
+            {"drawSprite/aligned", 8, 8, true},
+            {"drawSprite/unaligned", 3, 8, true},
+            {"drawSprite/edge-wrap", 60, 28, true},
+            {"drawSprite/edge-clip", 60, 28, false},
+    };
+    auto display = std::make_shared<c8_display>();
+    for(const sprite_case &c : SPRITE_CASES) {
+        kernels.emplace_back(c.name, [display, c]() {
+            uint8_t VF;
+            display->drawSprite(SPRITE, c.x, c.y, sizeof(SPRITE), 1, VF, c.wrap);
+            keep(VF);
+        });
+    }
+    kernels.emplace_back("clear", [display]() {
+        display->clear();
+        keep(display->rows);
+    });
+
+    // SUPER-CHIP 128x64: a 16x16 sprite straddling both words of a row, and the scrolls
+    static const uint8_t WIDE_SPRITE[32] = {
+            0xFF, 0xFF, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01,
+            0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0xFF, 0xFF
+    };
+    auto hires = std::make_shared<c8_display>();
+    hires->setHires(true);
+    kernels.emplace_back("drawSprite/hires-16x16", [hires]() {
+        uint8_t VF;
+        hires->drawSprite(WIDE_SPRITE, 57, 20, 0, 1, VF, true);
+        keep(VF);
+    });
+    // XO-CHIP: both planes drawn in one pass, each from its own half of the data
+    kernels.emplace_back("drawSprite/hires-2-planes", [hires]() {
+        uint8_t VF;
+        hires->drawSprite(WIDE_SPRITE, 57, 20, 8, 3, VF, true);
+        keep(VF);
+    });
+    kernels.emplace_back("scroll/down", [hires]() {
+        hires->scroll(0, 4);
+        keep(hires->rows);
+    });
+    kernels.emplace_back("scroll/right", [hires]() {
+        hires->scroll(4, 0);
+        keep(hires->rows);
+    });
+
+    auto phosphor = std::make_shared<std::vector<uint8_t>>(HIRES_WIDTH * HIRES_HEIGHT * c8_display::PLANES, 0);
+    auto lit = std::make_shared<c8_display>();
+    for(int y = 0; y < WINDOW_HEIGHT; y++) {
+        lit->rows[0][y][0] = 0x9249249249249249ULL >> (y % 3);
+    }
+    kernels.emplace_back("decayPhosphor", [lit, phosphor]() {
+        decayPhosphor(*lit, phosphor->data(), 0.8f);
+        keep(phosphor->front());
+    });
+
+    auto machine = std::make_shared<c8_machine>();
+    machine->reset((const uint8_t *) DEMO_ROM, sizeof(DEMO_ROM), 0);
+    c8_quirks quirks{};
+    kernels.emplace_back("print_instruction", [machine, quirks]() {
+        // walk the typography and program instead of disassembling the same word every time
+        static uint16_t pc = 0;
+        std::string line = print_instruction(pc, machine->state, quirks);
+        keep(line);
+        pc = (pc + 2) % 0x300;
+    });
+
+    auto snapshot = std::make_shared<c8_machine_snapshot>();
+    kernels.emplace_back("machine/save", [machine, snapshot]() {
+        machine->save(*snapshot);
+        keep(snapshot->cycle);
+    });
+    kernels.emplace_back("machine/restore", [machine, snapshot]() {
+        machine->restore(*snapshot);
+        keep(machine->cycle);
+    });
+    auto stateCopy = std::make_shared<c8_state>();
+    kernels.emplace_back("state/copy", [machine, stateCopy]() {
+        *stateCopy = machine->state;
+        keep(stateCopy->pc);
+    });
+
+    size_t nameWidth = 0;
+    for(const auto &kernel : kernels)
+        nameWidth = std::max(nameWidth, kernel.first.size() + 2);
+
+    std::vector<microbench_result> results;
+    std::cout << std::left << std::setw(nameWidth) << "kernel" << std::right << std::setw(12) << "median ns"
+              << std::setw(12) << "mean ns" << std::setw(12) << "+/- 95%" << std::setw(8) << "rsd" << std::endl;
+    for(const auto &kernel : kernels) {
+        if(!filter.empty() && kernel.first.find(filter) == std::string::npos)
+            continue;
+        microbench_result r = measure(kernel.first, kernel.second, samples, minSeconds);
+        results.push_back(r);
+        std::cout << std::left << std::setw(nameWidth) << r.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << r.median << std::setw(12) << r.mean << std::setw(12) << r.ci95
+                  << std::setprecision(1) << std::setw(7) << r.relativeStdDev * 100 << "%" << std::endl;
+    }
+
+    if(!jsonPath.empty() && !writeJSON(jsonPath, results, samples)) {
+        std::cerr << "Could not write " << jsonPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
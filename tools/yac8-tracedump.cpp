@@ -0,0 +1,117 @@
+/**
+ * Decodes a binary execution trace written by c8_tracer into one line of text per instruction:
+ *
+ *     yac8-tracedump trace.c8t > trace.txt
+ *
+ * Register values shown in the disassembly are the ones the instruction saw; the registers it changed follow.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "c8_state.hpp"
+#include "c8_tracer.hpp"
+#include "c8_debug.hpp"
+
+using namespace yac8;
+
+static bool get(std::istream &in, uint64_t &value, int bytes) {
+    unsigned char buffer[8];
+    if(!in.read(reinterpret_cast<char *>(buffer), bytes))
+        return false;
+    value = 0;
+    for(int i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+    }
+    return true;
+}
+
+static bool getVarint(std::istream &in, uint64_t &value) {
+    value = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if(c == EOF)
+            return false;
+        value |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if((c & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    if(argc != 2) {
+        std::cerr << "usage: yac8-tracedump <trace file>" << std::endl;
+        return 1;
+    }
+    std::ifstream in(argv[1], std::ios::in | std::ios::binary);
+    char magic[8];
+    uint64_t version, packedQuirks;
+    if(!in.read(magic, sizeof(magic)) || std::memcmp(magic, "YAC8TRCE", sizeof(magic)) != 0
+       || !get(in, version, 4) || version != 2 || !get(in, packedQuirks, 2)) {
+        std::cerr << argv[1] << " is not a yac8 trace" << std::endl;
+        return 1;
+    }
+    c8_quirks quirks = unpackQuirks(static_cast<uint16_t>(packedQuirks));
+
+    // registers as of the previous record, i.e. what the next instruction sees
+    c8_state state;
+    uint64_t cycle = 0, flags, opcode, lastOpcode = 0, longAddress = 0, pc = 0, I, sp, changed, value;
+    bool first = true;
+    while(get(in, flags, 1) && get(in, opcode, 2)) {
+        if(opcode == 0xF000 && !get(in, longAddress, 2))
+            return 1;
+        // fields that aren't there follow on from the previous record
+        if(flags & TRACE_CYCLE) {
+            if(!getVarint(in, cycle))
+                return 1;
+        } else if(!first) {
+            cycle++;
+        }
+        if(flags & TRACE_PC) {
+            if(!get(in, pc, 2))
+                return 1;
+        } else if(!first) {
+            pc = (pc + (lastOpcode == 0xF000 ? 4 : 2)) & 0xFFFF;
+        }
+        first = false;
+        lastOpcode = opcode;
+        I = state.I;
+        sp = state.sp;
+        changed = 0;
+        if(((flags & TRACE_I) && !get(in, I, 2)) || ((flags & TRACE_SP) && !get(in, sp, 1))
+           || ((flags & TRACE_V) && !get(in, changed, 2)))
+            return 1;
+
+        if(pc <= RAM_SIZE - 2) {
+            state.ram[pc] = static_cast<uint8_t>(opcode >> 8);
+            state.ram[pc + 1] = static_cast<uint8_t>(opcode);
+        }
+        if(opcode == 0xF000 && pc <= RAM_SIZE - 4) {
+            state.ram[pc + 2] = static_cast<uint8_t>(longAddress >> 8);
+            state.ram[pc + 3] = static_cast<uint8_t>(longAddress);
+        }
+        std::cout << std::dec << cycle << "\t" << print_instruction(static_cast<int>(pc), state, quirks);
+
+        std::cout << "\t;";
+        for(int r = 0; r < V_REGISTERS_SIZE; r++) {
+            if(changed & (1 << r)) {
+                if(!get(in, value, 1))
+                    return 1;
+                state.v[r] = static_cast<uint8_t>(value);
+                std::cout << " V" << std::hex << std::uppercase << r << std::nouppercase << "=" << hx(2) << value;
+            }
+        }
+        if(I != state.I)
+            std::cout << " I=" << hx(3) << I;
+        if(sp != state.sp)
+            std::cout << " SP=" << std::dec << sp;
+        std::cout << "\n";
+
+        state.I = static_cast<uint16_t>(I);
+        state.sp = static_cast<uint8_t>(sp);
+    }
+    return 0;
+}